@@ -445,3 +445,154 @@ def read_convergence (root ):
     final_conv = conv_fraction [-1]
     return final_conv
 		
+
+
+def read_delay_dump(filename):
+
+    '''
+    Read a binary delay dump file, written by Python when
+    reverb.dump_format is 1
+
+    Parameters
+    ----------
+    filename : str
+        The delay dump file, usually root.delay_dump
+
+    Returns
+    ----------
+    columns : dict
+        numpy arrays keyed by column name: freq, weight, delay
+        (doubles) and spectrum, origin, nres, nscat, nrscat,
+        extracted (ints).  Chunks written by different threads
+        are simply concatenated.
+
+    A transfer function can then be made directly from the
+    arrays, e.g. for the first extracted angle
+        s = columns['spectrum'] == 0
+        np.histogram2d(columns['delay'][s], columns['freq'][s],
+                       weights=columns['weight'][s], bins=100)
+    '''
+
+    dnames = ['freq', 'weight', 'delay']
+    inames = ['spectrum', 'origin', 'nres', 'nscat', 'nrscat', 'extracted']
+
+    data = open(filename, 'rb').read()
+
+    if data[:7] != b'PYDELAY':
+        print("read_delay_dump: %s is not a binary delay dump" % filename)
+        return 1
+
+    version, ndouble, nint = np.frombuffer(data, dtype=np.int32, count=3, offset=8)
+    if ndouble != len(dnames) or nint != len(inames):
+        print("read_delay_dump: %s has an unknown set of columns" % filename)
+        return 1
+
+    chunks = {name: [] for name in dnames + inames}
+    pos = 20
+    while pos < len(data):
+        nrows = int(np.frombuffer(data, dtype=np.int32, count=1, offset=pos)[0])
+        pos += 4
+        for name in dnames:
+            chunks[name].append(np.frombuffer(data, dtype=np.float64, count=nrows, offset=pos))
+            pos += 8 * nrows
+        for name in inames:
+            chunks[name].append(np.frombuffer(data, dtype=np.int32, count=nrows, offset=pos))
+            pos += 4 * nrows
+
+    columns = {}
+    for name in dnames + inames:
+        if len(chunks[name]) > 0:
+            columns[name] = np.concatenate(chunks[name])
+        else:
+            columns[name] = np.array([])
+
+    return columns
+
+
+def read_transfer_function(filename):
+
+    '''
+    Read a transfer function file, written by Python when
+    reverb.transfer_function is 1
+
+    Parameters
+    ----------
+    filename : str
+        The transfer function file, usually root.tf
+
+    Returns
+    ----------
+    tf : array
+        The transfer function, indexed [spectrum, freq, delay].
+        Like the spectra during a run, this is the sum over the
+        cycles completed so far, so multiply by the total
+        number of spectral cycles over ncycles if the run has
+        not finished
+    freq : array
+        The edges of the frequency bins
+    delay : array
+        The edges of the delay bins, in seconds
+    ncycles : int
+        The number of spectral cycles that went into tf
+    '''
+
+    data = open(filename, 'rb').read()
+
+    if data[:4] != b'PYTF':
+        print("read_transfer_function: %s is not a transfer function file" % filename)
+        return 1
+
+    nspec, nfreq, ndelay, ncycles = np.frombuffer(data, dtype=np.int32, count=4, offset=8)
+    fmin, fmax, delay_max = np.frombuffer(data, dtype=np.float64, count=3, offset=24)
+    tf = np.frombuffer(data, dtype=np.float64, count=nspec * nfreq * ndelay, offset=48)
+    tf = tf.reshape((nspec, nfreq, ndelay))
+
+    freq = np.linspace(fmin, fmax, nfreq + 1)
+    delay = np.linspace(0.0, delay_max, ndelay + 1)
+
+    return tf, freq, delay, int(ncycles)
+
+
+def read_table_binary(filename, columns=None):
+
+    '''
+    Read a binary table written by windsave2table, such as
+    root.0.master.bin
+
+    Parameters
+    ----------
+    filename : str
+        The binary table
+    columns : list of str
+        The columns to read.  If None, all of them are read.
+        Only the requested columns are read from the file.
+
+    Returns
+    ----------
+    table : dict
+        numpy arrays keyed by column name
+    '''
+
+    f = open(filename, 'rb')
+
+    if f.read(8)[:7] != b'PYTABLE':
+        print("read_table_binary: %s is not a binary table" % filename)
+        return 1
+
+    ncols, nrows = np.frombuffer(f.read(8), dtype=np.int32)
+    names = [f.read(20).split(b'\0')[0].decode() for i in range(ncols)]
+    start = f.tell()
+
+    if columns is None:
+        columns = names
+
+    table = {}
+    for name in columns:
+        if name not in names:
+            print("read_table_binary: no column %s in %s" % (name, filename))
+            continue
+        f.seek(start + 8 * nrows * names.index(name))
+        table[name] = np.frombuffer(f.read(8 * nrows), dtype=np.float64)
+
+    f.close()
+    return table
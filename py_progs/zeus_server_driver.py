@@ -0,0 +1,188 @@
+#!/usr/bin/env python
+
+'''
+                    Southampton University
+
+
+Synopsis:
+	This is a minimal stand in for a hydro code, which
+	drives python when it is running as a server
+	(the -zs switch).  It is intended for testing the
+	exchange of data through the fifos, and as an
+	example of the protocol a real hydro code has to
+	follow
+
+
+Description:
+
+	zeus_server_driver.py [-n nsteps] [-c ncycles] [-f factor] root hydro_file
+
+	The hydro file is the one python read at startup.
+	For each step the density is multiplied by factor,
+	the hydro arrays are sent to root.zeus_in, ncycles
+	ionization cycles are requested, and the heating
+	and cooling rates are read back from root.zeus_out.
+	After nsteps steps the server is told to stop.
+
+Arguments:
+
+	-n nsteps	the number of steps (default 3)
+	-c ncycles	the ionization cycles per step (default 1)
+	-f factor	the factor by which the density changes
+			between steps (default 1.1)
+	root		the root name of the python run
+	hydro_file	the hydro file python read at startup
+
+Returns:
+
+	A summary of the rates returned for each step
+
+Notes:
+
+	The layout of the messages is described in zeus_server
+	in run.c.  All data is binary in the native byte order.
+	Python has to have been started first, with something like
+
+	py -z -zs root &
+
+	python creates the fifos when it has finished the first
+	step, so we wait for them to appear before opening them.
+	python opens root.zeus_in first, so we do too, otherwise
+	the two programs wait for each other.
+
+History:
+17oct		Coded to test the -zs server mode
+
+
+'''
+
+import sys
+import os
+import stat
+import struct
+import time
+
+
+NAMES=['heat_photo','heat_comp','heat_lines','heat_ff','cool_comp','cool_lines','cool_ff','dmo_dt_x','dmo_dt_y','dmo_dt_z']
+
+
+def read_hydro(filename):
+	'''
+	Read the hydro file python read at startup, and return nr, ntheta
+	and the rho, temp, v_r, v_theta, v_phi arrays, each with theta
+	varying fastest
+	'''
+
+	cells={}
+	nr=ntheta=0
+	f=open(filename,'r')
+	for line in f.readlines():
+		z=line.split()
+		if len(z)==0 or z[0][0]=='#' or z[0][0:2]=='ir':
+			continue
+		i=int(z[0])
+		j=int(z[3])
+		cells[(i,j)]=[float(z[9]),float(z[10]),float(z[6]),float(z[7]),float(z[8])]
+		nr=max(nr,i+1)
+		ntheta=max(ntheta,j+1)
+	f.close()
+
+	arrays=[]
+	for k in range(5):
+		for i in range(nr):
+			for j in range(ntheta):
+				arrays.append(cells[(i,j)][k])
+	return nr,ntheta,arrays
+
+
+def wait_for_fifo(filename,tmax=3600.):
+	'''
+	Wait until python has created the fifo filename
+	'''
+
+	tstart=time.time()
+	while not (os.path.exists(filename) and stat.S_ISFIFO(os.stat(filename).st_mode)):
+		if time.time()-tstart>tmax:
+			print('Error: %s was not created within %.0f s' % (filename,tmax))
+			sys.exit(1)
+		time.sleep(1)
+
+
+def read_exactly(f,nbytes):
+	'''
+	Read nbytes from the fifo, failing if python has gone away
+	'''
+
+	data=f.read(nbytes)
+	if len(data)!=nbytes:
+		print('Error: python stopped before sending %d bytes' % nbytes)
+		sys.exit(1)
+	return data
+
+
+def step(fin,fout,nr,ntheta,ncycles,arrays):
+	'''
+	Send one set of hydro data and read back the rates
+	'''
+
+	fin.write(struct.pack('3i',nr,ntheta,ncycles))
+	fin.write(struct.pack('%dd' % len(arrays),*arrays))
+	fin.flush()
+
+	ncells,nvalues=struct.unpack('2i',read_exactly(fout,8))
+	ij=struct.unpack('%di' % (2*ncells),read_exactly(fout,8*ncells))
+	values=struct.unpack('%dd' % (ncells*nvalues),read_exactly(fout,8*ncells*nvalues))
+	return ncells,nvalues,ij,values
+
+
+def doit(root,hydro_file,nsteps=3,ncycles=1,factor=1.1):
+	'''
+	Run nsteps steps, and then stop the server
+	'''
+
+	nr,ntheta,arrays=read_hydro(hydro_file)
+	ncells=nr*ntheta
+	print('Read a %d x %d grid from %s' % (nr,ntheta,hydro_file))
+
+	wait_for_fifo(root+'.zeus_in')
+	wait_for_fifo(root+'.zeus_out')
+	fin=open(root+'.zeus_in','wb')
+	fout=open(root+'.zeus_out','rb')
+
+	for n in range(nsteps):
+		for k in range(ncells):
+			arrays[k]=arrays[k]*factor
+		ncells_back,nvalues,ij,values=step(fin,fout,nr,ntheta,ncycles,arrays)
+		print('Step %d: %d cells with %d values each' % (n,ncells_back,nvalues))
+		for k in range(nvalues):
+			total=0.0
+			for m in range(ncells_back):
+				total=total+values[m*nvalues+k]
+			print('   %-12s mean %10.3e' % (NAMES[k] if k<len(NAMES) else 'value%d' % k,total/max(ncells_back,1)))
+
+	fin.write(struct.pack('3i',nr,ntheta,0))
+	fin.close()
+	fout.close()
+	print('Stopped the server after %d steps' % nsteps)
+
+
+if __name__ == "__main__":
+	args=sys.argv[1:]
+	nsteps=3
+	ncycles=1
+	factor=1.1
+	while len(args)>2 and args[0][0]=='-':
+		if args[0]=='-n':
+			nsteps=int(args[1])
+		elif args[0]=='-c':
+			ncycles=int(args[1])
+		elif args[0]=='-f':
+			factor=float(args[1])
+		else:
+			print(__doc__)
+			sys.exit(1)
+		args=args[2:]
+	if len(args)!=2:
+		print(__doc__)
+		sys.exit(1)
+	doit(args[0],args[1],nsteps,ncycles,factor)
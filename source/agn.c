@@ -335,6 +335,7 @@ photo_gen_agn (p, r, alpha, weight, f1, f2, spectype, istart, nphot)
   int i, iend;
   int n;
   double ftest;
+  double zagn;
 
   t = alpha;                    /* NSH 130605, this is a slightly odd statmenent, put in to avoid 03 compilation 
                                    errors, but stemming from the odd behaviour that one can give the AGN a 
@@ -434,15 +435,16 @@ photo_gen_agn (p, r, alpha, weight, f1, f2, spectype, istart, nphot)
       {
         /* JM XXX -- is this bit right? it seems to be that zdisk should use the x coordinate rather than
            magnitude of vector (r) */
-        while (fabs (p[i].x[2]) < zdisk (r))
+        zagn = zdisk (r);
+        while (fabs (p[i].x[2]) < zagn)
         {
           randvec (p[i].x, r);
         }
 
 
-        if (fabs (p[i].x[2]) < zdisk (r))
+        if (fabs (p[i].x[2]) < zagn)
         {
-          Error ("Photon_agn: agn photon %d in disk %g %g %g %g %g\n", i, p[i].x[0], p[i].x[1], p[i].x[2], zdisk (r), r);
+          Error ("Photon_agn: agn photon %d in disk %g %g %g %g %g\n", i, p[i].x[0], p[i].x[1], p[i].x[2], zagn, r);
           exit (0);
         }
       }
@@ -573,3 +573,22 @@ Gaunt_total gaunt_total[MAX_GAUNT_N_GSQRD];     //Set up the structure
 /* a variable which controls whether to save a summary of atomic data
    this is defined in atomic.h, rather than the modes structure */
 int write_atomicdata;
+
+/* a variable which controls whether the atomic data is read from and written to a binary
+   cache alongside the masterfile, see atomic_cache_read.  It is a bitmask of the following */
+#define ATOMIC_CACHE_READ	1
+#define ATOMIC_CACHE_WRITE	2
+int atomic_cache;
+
+/* The header of the atomic data cache.  It holds the key used to check the cache was made
+   from the current input files, and all of the counts needed to size the arrays that follow */
+typedef struct atomic_cache_head
+{
+  char magic[8];
+  unsigned long long key;
+  long nbytes;                  /* the number of bytes of array data after the header */
+  int nelements, nions, nlevels, nlte_levels, nlevels_macro, nlines, nlines_macro;
+  int n_inner_tot, nauger, n_coll_stren, nxphot, ntop_phot, nphot_total, nxcol;
+  int ndrecomb, ncpart, n_total_rr, n_bad_gs_rr, n_dere_di_rate, gaunt_n_gsqrd;
+  double phot_freq_min, inner_freq_min, rho2nh;
+} Atomic_cache_head, *Atomic_cache_headPtr;
@@ -675,3 +675,99 @@ freqs_init (freqmin, freqmax)
   return (0);
 
 }
+
+
+
+/***********************************************************
+                University of Southampton
+
+Synopsis:
+	bands_adapt uses the photon statistics of the last ionization
+	cycle to decide how photons should be distributed among the
+	photon generation bands in the next one, when geo.adaptive_bands
+	is set.
+
+Arguments:
+     struct xbands *band;	A pointer to the structure that holds the band information
+
+Returns:
+
+	The results are put in band->adapt_fraction, and used by populate_bands
+
+Description:
+
+	For each cell that has not converged (or had no photons at all), the
+	number of photon passages that fell in each generation band is estimated
+	from nxtot, the passages in the coarser frequency intervals geo.xfreq,
+	assuming they are spread uniformly in log frequency within each interval.
+	The cell then contributes 1/sqrt(1+N) to the need of the band, i.e. the
+	relative noise of an estimator made with N photons.  Bands which are poorly
+	sampled in many unconverged cells therefore get more photons.  Converged
+	cells do not contribute, so if the whole grid is converged the standard
+	fractions are used.
+
+Notes:
+
+	This must be called after the plasma structure has been brought up to
+	date on all threads, since each thread must arrive at the same fractions.
+	The photon weights which compensate for the change in sampling are
+	calculated in define_phot, in the same way as for min_fraction.
+
+History:
+
+**************************************************************/
+
+int
+bands_adapt (band)
+     struct xbands *band;
+{
+  int n, i, nplasma;
+  double need[NBANDS], npass, overlap, lf1, lf2, lx1, lx2;
+  double need_tot;
+
+  for (n = 0; n < NBANDS; n++)
+    need[n] = band->adapt_fraction[n] = 0.0;
+
+  if (geo.adaptive_bands == 0)
+    return (0);
+
+  need_tot = 0;
+  for (nplasma = 0; nplasma < NPLASMA; nplasma++)
+  {
+    if (plasmamain[nplasma].converge_whole == 0 && plasmamain[nplasma].ntot > 0)
+      continue;
+
+    for (n = 0; n < band->nbands; n++)
+    {
+      if (band->f1[n] >= band->f2[n])
+        continue;
+
+      lf1 = log (band->f1[n]);
+      lf2 = log (band->f2[n]);
+      npass = 0;
+      for (i = 0; i < geo.nxfreq; i++)
+      {
+        lx1 = log (geo.xfreq[i]);
+        lx2 = log (geo.xfreq[i + 1]);
+        overlap = ((lf2 < lx2) ? lf2 : lx2) - ((lf1 > lx1) ? lf1 : lx1);
+        if (overlap > 0 && lx2 > lx1)
+          npass += plasmamain[nplasma].nxtot[i] * overlap / (lx2 - lx1);
+      }
+      need[n] += 1. / sqrt (1. + npass);
+    }
+  }
+
+  for (n = 0; n < band->nbands; n++)
+    need_tot += need[n];
+
+  if (need_tot > 0)
+  {
+    for (n = 0; n < band->nbands; n++)
+    {
+      band->adapt_fraction[n] = need[n] / need_tot;
+      Log ("bands_adapt: band %2d %8.2e %8.2e adaptive fraction %6.3f\n", n, band->f1[n], band->f2[n], band->adapt_fraction[n]);
+    }
+  }
+
+  return (0);
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "atomic.h"
 #include "python.h"
@@ -63,7 +64,7 @@ one_continuum (spectype, t, g, freqmin, freqmax)
      int spectype;
      double t, g, freqmin, freqmax;
 {
-  //OLD not used in routine double par[2];              // For python we assume only two parameter models
+  double par[2];                // For python we assume only two parameter models
   double lambdamin, lambdamax;
   double f;
   double pdf_get_rand ();
@@ -72,9 +73,9 @@ one_continuum (spectype, t, g, freqmin, freqmax)
 
   if (old_t != t || old_g != g || old_freqmin != freqmin || old_freqmax != freqmax)
   {                             /* Then we must initialize */
-    //OLD not used in routine par[0] = t;
-    //OLD not used in routine par[1] = g;
-    //OLD nwav not used here ksl.  nwav = model (spectype, par);
+    par[0] = t;
+    par[1] = g;
+    model (spectype, par);
     /*  Get_model returns wavelengths in Ang and flux in ergs/cm**2/Ang */
     lambdamin = C * 1e8 / freqmax;
     lambdamax = C * 1e8 / freqmin;
@@ -105,6 +106,139 @@ one_continuum (spectype, t, g, freqmin, freqmax)
 
 
 
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+int disk_pdf_init(spectype,freqmin,freqmax) makes the cumulative distributions
+of the model spectra of each of the disk annulae
+
+Arguments:
+
+	spectype				The continuum grid used for the disk
+	freqmin,freqmax;			minimum and maximum frequency of interest
+
+Returns:
+
+	0 
+ 
+Description:	
+
+one_continuum only remembers the last cumulative distribution it made,
+and since each photon generated by photo_gen_disk comes from a randomly
+chosen annulus, nearly every disk photon caused the distribution to be 
+remade.  Here one distribution is made for each annulus, once per
+call to disk_init, and disk_continuum then samples the one for
+the annulus that was chosen.
+
+A distribution is only remade if the temperature, gravity or frequency
+range of its annulus has changed since it was made.
+
+Notes:
+
+**************************************************************/
+
+int
+disk_pdf_init (spectype, freqmin, freqmax)
+     int spectype;
+     double freqmin, freqmax;
+{
+  int n, nremade;
+  double par[2];
+  double lambdamin, lambdamax;
+  int model ();
+
+  lambdamin = C * 1e8 / freqmax;
+  lambdamax = C * 1e8 / freqmin;
+
+  if (spectype != disk_pdf_spectype || freqmin != disk_pdf_freqmin || freqmax != disk_pdf_freqmax)
+  {
+    for (n = 0; n < NRINGS; n++)
+      disk_pdf_t[n] = disk_pdf_g[n] = -1;
+  }
+
+  nremade = 0;
+  for (n = 0; n < NRINGS - 1; n++)
+  {
+    par[0] = disk.t[n];
+    par[1] = log10 (disk.g[n]);
+    if (par[0] == disk_pdf_t[n] && par[1] == disk_pdf_g[n])
+      continue;
+
+    model (spectype, par);
+    if (pdf_gen_from_array (&disk_pdf[n], comp[spectype].xmod.w, comp[spectype].xmod.f, comp[spectype].nwaves, lambdamin, lambdamax, 1, jump)
+        != 0)
+    {
+      Error ("disk_pdf_init: after return from pdf_gen_from_array for annulus %d\n", n);
+    }
+    disk_pdf_t[n] = par[0];
+    disk_pdf_g[n] = par[1];
+    nremade++;
+  }
+
+  disk_pdf_spectype = spectype;
+  disk_pdf_freqmin = freqmin;
+  disk_pdf_freqmax = freqmax;
+  disk_pdf_ok = TRUE;
+
+  Log_silent ("disk_pdf_init: Made %d of %d distributions for the disk annulae\n", nremade, NRINGS - 1);
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+double disk_continuum(nring,freqmin,freqmax) gets a photon frequency 
+from the model spectrum of a disk annulus 
+
+Arguments:
+
+	nring					The annulus
+	freqmin,freqmax;			minimum and maximum frequency of interest
+
+Returns:
+
+	The frequency of the photon
+ 
+Description:	
+
+This is the equivalent of one_continuum, using the distributions
+made by disk_pdf_init.
+
+Notes:
+
+**************************************************************/
+
+double
+disk_continuum (nring, freqmin, freqmax)
+     int nring;
+     double freqmin, freqmax;
+{
+  double f;
+  double pdf_get_rand ();
+
+  f = (C * 1.e8 / pdf_get_rand (&disk_pdf[nring]));
+  if (f > freqmax)
+  {
+    Error ("disk_continuum: f too large %e\n", f);
+    f = freqmax;
+  }
+  if (f < freqmin)
+  {
+    Error ("disk_continuum: f too small %e\n", f);
+    f = freqmin;
+  }
+  return (f);
+}
+
+
+
 double
 emittance_continuum (spectype, freqmin, freqmax, t, g)
      int spectype;
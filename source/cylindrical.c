@@ -237,10 +237,293 @@ cylind_make_grid (ndom, w)
     }
   }
 
+  if (one_dom->adapt_grid > 0)
+    cylind_adapt_grid (ndom, w);
+
   return (0);
 }
 
 
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	cylind_adapt_grid moves the lines of a cylindrical grid so that 
+	they are concentrated where the density and velocity of the wind 
+	change most rapidly
+
+Arguments:		
+	int ndom;	The domain
+	WindPtr w;	The structure which defines the wind in Python
+ 
+Returns:
+ 
+Description:
+
+The grid made by cylind_make_grid is either logarithmic, so the cells are 
+equally spaced in u = ln x and ln z, or linear, so they are equally spaced 
+in u = x / dx and z / dz, where dx and dz are the widths of the linear cells.  
+Here the spacing in u is instead chosen so that each cell contains an equal 
+share of the integral of 
+
+	M = 1 + adapt_grid * max |d ln rho / d u| + |d ln v / d u|
+
+where the maximum is taken over the rows of cells in z, and similarly for z.
+Where the wind is smooth, M is 1 and the grid is the one made by 
+cylind_make_grid.  Where the density or velocity change rapidly, for example 
+near the disk plane, at the base of the wind or at its edges, more of the 
+cells are used.  The result is a finer grid where it matters for the same 
+number of cells.
+
+The inner and outer lines, x=0 (and for a logarithmic grid the first line
+beyond it), rmax and zmax, and the lines beyond rmax and zmax which are
+needed for interpolation, are kept.
+
+Notes:
+
+The grid is still a rectangular (tensor product) grid, so where_in_grid,
+cylind_ds_in_cell and the volume calculations are unchanged.  Refining
+individual cells, as in a quadtree, would require changes to all of these.
+
+The density and velocity are those of the analytic wind model, so this is
+only done when the grid is made.
+
+Since each linear cell has a weight of 1 in the integral, rather than the 
+ln (rmax / xlog_scale) / (ndim - 3) of a logarithmic cell, the same value of 
+adapt_grid moves the lines of a linear grid rather less.
+
+**************************************************************/
+
+int
+cylind_adapt_grid (ndom, w)
+     int ndom;
+     WindPtr w;
+{
+  int i, j, n, nstart, ndim, mdim, lo;
+  double xedge[NDIM_MAX + 1], zedge[NDIM_MAX + 1];
+  double xold[NDIM_MAX], zold[NDIM_MAX];
+  double xfudge;
+  DomainPtr one_dom;
+
+  one_dom = &zdom[ndom];
+  nstart = one_dom->nstart;
+  ndim = one_dom->ndim;
+  mdim = one_dom->mdim;
+
+  if (ndim < 5 || mdim < 5)
+  {
+    Error ("cylind_adapt_grid: Grid %d x %d too small to adapt\n", ndim, mdim);
+    return (0);
+  }
+
+  for (i = 0; i < ndim; i++)
+    xold[i] = w[nstart + i * mdim].x[0];
+  for (j = 0; j < mdim; j++)
+    zold[j] = w[nstart + j].x[2];
+
+  cylind_adapt_edges (ndom, 0, xold, ndim, zold, mdim, xedge);
+  cylind_adapt_edges (ndom, 2, zold, mdim, xold, ndim, zedge);
+
+  for (i = 0; i < ndim; i++)
+  {
+    for (j = 0; j < mdim; j++)
+    {
+      n = nstart + i * mdim + j;
+      w[n].x[0] = xedge[i];
+      w[n].x[2] = zedge[j];
+      w[n].xcen[0] = 0.5 * (xedge[i] + xedge[i + 1]);
+      w[n].xcen[2] = 0.5 * (zedge[j] + zedge[j + 1]);
+      xfudge = fmin ((w[n].xcen[0] - w[n].x[0]), (w[n].xcen[2] - w[n].x[2]));
+      w[n].dfudge = XFUDGE * xfudge;
+    }
+  }
+
+  /* The lines which are kept fixed are 0 to lo, and ndim - 3 + lo, which is rmax (or zmax) */
+  lo = (one_dom->log_linear == 1) ? 0 : 1;
+
+  Log ("cylind_adapt_grid: Adapted %s grid for domain %d.  Smallest cells dx %.2e dz %.2e, outermost dx %.2e dz %.2e\n",
+       (one_dom->log_linear == 1) ? "linear" : "logarithmic", ndom,
+       cylind_adapt_min (xedge, lo, ndim - 3 + lo), cylind_adapt_min (zedge, lo, mdim - 3 + lo),
+       xedge[ndim - 3 + lo] - xedge[ndim - 4 + lo], zedge[mdim - 3 + lo] - zedge[mdim - 4 + lo]);
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	cylind_adapt_edges finds the positions of the grid lines in one 
+	direction for cylind_adapt_grid
+
+Arguments:		
+	int ndom;		The domain
+	int idir;		0 for lines of constant x, 2 for lines of constant z
+	double old[];		The present grid lines in this direction
+	int n;			The number of lines in this direction
+	double other[];		The present grid lines in the other direction
+	int nother;		The number of lines in the other direction
+ 
+Returns:
+	double edge[];		The new grid lines, with an extra one beyond the 
+				last so that the centers of all the cells can be
+				calculated.  There must be room for n+1 values.
+ 
+Description:
+
+The monitor function is sampled NADAPT points per cell between old[lo] and
+old[hi], along the centers of the cells in the other direction, and the new
+lines lo+1 to hi-1 are placed at equal intervals of its integral.  For a
+logarithmic grid lo is 1 and hi is n-2, and the sampling is in ln x, while for
+a linear grid lo is 0 and hi is n-3, and the sampling is in x.
+
+Notes:
+
+**************************************************************/
+
+#define NADAPT  20
+
+int
+cylind_adapt_edges (ndom, idir, old, n, other, nother, edge)
+     int ndom, idir;
+     double old[];
+     int n;
+     double other[];
+     int nother;
+     double edge[];
+{
+  int i, k, m, nsamp, iother, linear, lo, hi, mmax;
+  double ulo, uhi, du, u, target, frac, weight;
+  double x[3], v[3];
+  double *rho, *vel, *cum;
+  double rhomax, velmax, grad, gmax;
+
+  iother = (idir == 0) ? 2 : 0;
+  linear = (zdom[ndom].log_linear == 1);
+
+  /* The region of interest is between lines lo and hi, and between 0 and mmax in the other direction */
+  lo = linear ? 0 : 1;
+  hi = n - 3 + lo;
+  mmax = nother - 3 + lo;
+
+  nsamp = NADAPT * (hi - lo) + 1;
+  if (linear)
+  {
+    ulo = old[lo];
+    uhi = old[hi];
+  }
+  else
+  {
+    ulo = log (old[lo]);
+    uhi = log (old[hi]);
+  }
+  du = (uhi - ulo) / (nsamp - 1);
+
+  /* The contribution of the uniform part of the monitor function to each sample, so 
+     that this is du in ln x for a logarithmic grid, and 1 / NADAPT for a linear one */
+  weight = linear ? 1. / NADAPT : du;
+
+  rho = calloc (nsamp * mmax, sizeof (double));
+  vel = calloc (nsamp * mmax, sizeof (double));
+  cum = calloc (nsamp, sizeof (double));
+
+  /* Sample the density and speed of the wind model along the centers of the cells in the other direction */
+
+  rhomax = velmax = 0;
+  for (m = 0; m < mmax; m++)
+  {
+    for (k = 0; k < nsamp; k++)
+    {
+      x[1] = 0;
+      x[idir] = linear ? ulo + k * du : exp (ulo + k * du);
+      x[iother] = 0.5 * (other[m] + other[m + 1]);
+      rho[m * nsamp + k] = model_rho (ndom, x);
+      model_velocity (ndom, x, v);
+      vel[m * nsamp + k] = length (v);
+      if (rho[m * nsamp + k] > rhomax)
+        rhomax = rho[m * nsamp + k];
+      if (vel[m * nsamp + k] > velmax)
+        velmax = vel[m * nsamp + k];
+    }
+  }
+
+  /* Integrate the monitor function.  The floors prevent the regions outside the wind 
+     from dominating */
+
+  cum[0] = 0;
+  for (k = 1; k < nsamp; k++)
+  {
+    gmax = 0;
+    for (m = 0; m < mmax; m++)
+    {
+      i = m * nsamp + k;
+      grad = fabs (rho[i] - rho[i - 1]) / (0.5 * (rho[i] + rho[i - 1]) + 1e-3 * rhomax);
+      grad += fabs (vel[i] - vel[i - 1]) / (0.5 * (vel[i] + vel[i - 1]) + 1e-3 * velmax);
+      if (grad > gmax)
+        gmax = grad;
+    }
+    cum[k] = cum[k - 1] + weight + zdom[ndom].adapt_grid * gmax;
+  }
+
+  /* Place the lines at equal intervals of the integral */
+
+  for (i = 0; i <= lo; i++)
+    edge[i] = old[i];
+  edge[hi] = old[hi];
+  k = 1;
+  for (i = lo + 1; i < hi; i++)
+  {
+    target = cum[nsamp - 1] * (i - lo) / (hi - lo);
+    while (k < nsamp - 1 && cum[k] < target)
+      k++;
+    frac = (target - cum[k - 1]) / (cum[k] - cum[k - 1]);
+    u = ulo + (k - 1 + frac) * du;
+    edge[i] = linear ? u : exp (u);
+  }
+
+  /* The last lines are beyond the region of interest, with the same spacing (linear) or 
+     ratio (logarithmic) as the last cell inside it */
+  for (i = hi + 1; i <= n; i++)
+  {
+    if (linear)
+      edge[i] = 2. * edge[i - 1] - edge[i - 2];
+    else
+      edge[i] = edge[i - 1] * edge[i - 1] / edge[i - 2];
+  }
+
+  free (rho);
+  free (vel);
+  free (cum);
+
+  return (0);
+}
+
+#undef NADAPT
+
+
+
+/* cylind_adapt_min returns the width of the smallest of the cells between edge[nmin] and edge[nmax] */
+
+double
+cylind_adapt_min (edge, nmin, nmax)
+     double edge[];
+     int nmin, nmax;
+{
+  int i;
+  double dmin;
+
+  dmin = edge[nmin + 1] - edge[nmin];
+  for (i = nmin + 1; i < nmax; i++)
+    if (edge[i + 1] - edge[i] < dmin)
+      dmin = edge[i + 1] - edge[i];
+
+  return (dmin);
+}
+
+
 /* This simple little routine just populates two one dimensional arrays that are used for interpolation.
  * It could be part of the routine above, except that the arrays are  not tranferred to py_wind in wind_save
  * It's left that way for now, but when one cleans up the program, it might be more sensible to do it the other
@@ -481,7 +764,6 @@ cylind_where_in_grid (ndom, x)
   int i, j, n;
   double z;
   double rho;
-  double f;
   DomainPtr one_dom;
 
   one_dom = &zdom[ndom];
@@ -501,8 +783,9 @@ cylind_where_in_grid (ndom, x)
   if (rho < one_dom->wind_x[0])
     return (-1);
 
-  fraction (rho, one_dom->wind_x, one_dom->ndim, &i, &f, 0);
-  fraction (z, one_dom->wind_z, one_dom->mdim, &j, &f, 0);
+  /* Photons usually move to a neighbouring cell, so start from the last cell found */
+  i = one_dom->wig_i = fraction_guess (rho, one_dom->wind_x, one_dom->ndim, one_dom->wig_i);
+  j = one_dom->wig_j = fraction_guess (z, one_dom->wind_z, one_dom->mdim, one_dom->wig_j);
 
   /* At this point i,j are just outside the x position */
   wind_ij_to_n (ndom, i, j, &n);
@@ -225,6 +225,35 @@ zdisk (r)
 }
 
 
+
+/***********************************************************
+             Space Telescope Science Institute
+ 
+ Synopsis:  zdisk_slope
+   
+ Arguments:
+        r       a radial position in the disk.
+ 
+ Returns:
+        dz/dr, the slope of the surface of the disk at r
+   
+Description:
+	Since zdisk is a power law, the slope is just disk_z1 * zdisk(r) / r,
+	and there is no need to difference zdisk.
+ 
+Notes:
+	For disk_z1 < 1 the slope is infinite at r = 0
+ 
+**************************************************************/
+
+double
+zdisk_slope (r)
+     double r;
+{
+  return (geo.disk_z0 * geo.disk_z1 * pow (r / geo.diskrad, geo.disk_z1 - 1.));
+}
+
+
 /***********************************************************
              Space Telescope Science Institute
  
@@ -266,9 +295,32 @@ History:
                                                                                        
 **************************************************************/
 
-int ds_to_disk_init = 0;
-struct photon ds_to_disk_photon;
-struct plane diskplane, disktop, diskbottom;
+/* The position and direction of the photon for which disk_deriv is finding the intercept
+   with the disk.  Only these are needed, so the rest of the photon is not copied. */
+
+double ds_to_disk_x[3], ds_to_disk_lmn[3];
+
+/* disk_plane_r returns the distance from the z axis at which a photon crosses the plane
+   z = height, and the path length to it in *s.  If the photon travels parallel to the 
+   plane, s is VERY_BIG.  This is what ds_to_plane followed by move_phot would give */
+
+double
+disk_plane_r (p, height, s)
+     struct photon *p;
+     double height, *s;
+{
+  double x, y;
+
+  if (p->lmn[2] == 0)
+    *s = VERY_BIG;
+  else
+    *s = (height - p->x[2]) / p->lmn[2];
+
+  x = p->x[0] + p->lmn[0] * (*s);
+  y = p->x[1] + p->lmn[1] * (*s);
+
+  return (sqrt (x * x + y * y));
+}
 
 double
 ds_to_disk (p, miss_return)
@@ -278,44 +330,16 @@ ds_to_disk (p, miss_return)
   double x1, x2;
   double s_plane, s_top, s_bottom, s_sphere, s_disk;
   double r_plane, r_top, r_bottom;
-  double smin, smax;
-  struct photon phit;
+  double smin, smax, zmax, z;
   void disk_deriv ();
 
 
   if (geo.disk_type == DISK_NONE)
     return (VERY_BIG);          /* There is no disk! */
 
-  if (ds_to_disk_init == 0)
-  {                             /* Initialize 3 structures that define
-                                   the plane of the disk, and two other
-                                   planes that encompass the disk */
+  /* Now calculate the place where the photon hits the plane of the disk */
 
-    diskplane.x[0] = diskplane.x[1] = diskplane.x[2] = 0.0;
-    diskplane.lmn[0] = diskplane.lmn[1] = 0.0;
-    diskplane.lmn[2] = 1.0;     //changed by SS August 04
-
-
-    disktop.x[0] = disktop.x[1] = 0.0;
-    disktop.x[2] = geo.diskrad * geo.disk_z0;
-    disktop.lmn[0] = disktop.lmn[1] = 0.0;
-    disktop.lmn[2] = 1.0;       //changed by SS August 04
-
-    diskbottom.x[0] = diskbottom.x[1] = 0.0;
-    diskbottom.x[2] = (-geo.diskrad * geo.disk_z0);
-    diskbottom.lmn[0] = diskbottom.lmn[1] = 0.0;
-    diskbottom.lmn[2] = 1.0;    //changed by SS August 04
-
-    ds_to_disk_init++;          // Only initialize once
-
-  }
-
-  /* Now calculate the place where the photon hits the diskplane */
-
-  s_plane = ds_to_plane (&diskplane, p);
-  stuff_phot (p, &phit);
-  move_phot (&phit, s_plane);
-  r_plane = sqrt (phit.x[0] * phit.x[0] + phit.x[1] * phit.x[1]);
+  r_plane = disk_plane_r (p, 0.0, &s_plane);
 
 
   if (geo.disk_type == DISK_FLAT)
@@ -328,19 +352,13 @@ ds_to_disk (p, miss_return)
   /* OK now we have to deal with the hard case.  We would like to
    * avoid actually having to calculate the intercept to the disk
    * if we can because this is likely time consuming. So we first
-   * determine this, by checking where the ray hits a sphere that 
-   * just encompasses the disk 
+   * determine this, by checking where the ray hits the two planes
+   * which just encompass the disk 
    */
 
-  s_top = ds_to_plane (&disktop, p);
-  stuff_phot (p, &phit);
-  move_phot (&phit, s_top);
-  r_top = sqrt (phit.x[0] * phit.x[0] + phit.x[1] * phit.x[1]);
-
-  s_bottom = ds_to_plane (&diskbottom, p);
-  stuff_phot (p, &phit);
-  move_phot (&phit, s_bottom);
-  r_bottom = sqrt (phit.x[0] * phit.x[0] + phit.x[1] * phit.x[1]);
+  zmax = geo.diskrad * geo.disk_z0;
+  r_top = disk_plane_r (p, zmax, &s_top);
+  r_bottom = disk_plane_r (p, -zmax, &s_bottom);
 
   /* Now if rtop and r_bottom are both greater than diskrad
    * then this photon missed the disk */
@@ -418,8 +436,12 @@ ds_to_disk (p, miss_return)
   }
 
 
-  stuff_phot (p, &ds_to_disk_photon);
-  move_phot (&ds_to_disk_photon, smin);
+  ds_to_disk_x[0] = p->x[0] + p->lmn[0] * smin;
+  ds_to_disk_x[1] = p->x[1] + p->lmn[1] * smin;
+  ds_to_disk_x[2] = p->x[2] + p->lmn[2] * smin;
+  ds_to_disk_lmn[0] = p->lmn[0];
+  ds_to_disk_lmn[1] = p->lmn[1];
+  ds_to_disk_lmn[2] = p->lmn[2];
 
   s_disk = rtsafe (disk_deriv, 0.0, smax - smin, fabs (smax - smin) / 1000.);
   //fabs added by SS August 04 - want convergence test quantity to be +ve 
@@ -433,9 +455,8 @@ ds_to_disk (p, miss_return)
    */
 
   s_sphere = ds_to_sphere (geo.diskrad, p);
-  stuff_phot (p, &phit);
-  move_phot (&phit, s_sphere);
-  if (fabs (phit.x[2]) < geo.disk_z0 * geo.diskrad)
+  z = p->x[2] + p->lmn[2] * s_sphere;
+  if (fabs (z) < zmax)
   {
     /* The photon actually hits the disk rim and you must then check whether it hits
      * the disk before the rim */
@@ -450,32 +471,30 @@ ds_to_disk (p, miss_return)
    between the photon and the disk.  The function we are trying to zero is the
    difference between the height of the disk and the z height of the photon. 
 
-   Minor modification by SS August 04 in case z1 = 0.
-
+   The derivative is calculated analytically from zdisk_slope, since 
+   dr/ds = (x lmn_x + y lmn_y) / r along the ray.  On the axis, where r = 0, 
+   dr/ds is the component of the direction in the xy plane.
 */
 
 void
 disk_deriv (s, value, derivative)
      double s, *value, *derivative;
 {
-  struct photon phit;
-  double z1, z2, r1, r2;
-  double ds;
+  double x, y, z, r, drds, dzds;
 
-  stuff_phot (&ds_to_disk_photon, &phit);
-  move_phot (&phit, s);
-  r1 = sqrt (phit.x[0] * phit.x[0] + phit.x[1] * phit.x[1]);
-  z1 = zdisk (r1) - fabs (phit.x[2]);   // this is the function
+  x = ds_to_disk_x[0] + ds_to_disk_lmn[0] * s;
+  y = ds_to_disk_x[1] + ds_to_disk_lmn[1] * s;
+  z = ds_to_disk_x[2] + ds_to_disk_lmn[2] * s;
+  r = sqrt (x * x + y * y);
 
-  /* OK now calculate the derivative */
+  if (r > 0)
+    drds = (x * ds_to_disk_lmn[0] + y * ds_to_disk_lmn[1]) / r;
+  else
+    drds = sqrt (ds_to_disk_lmn[0] * ds_to_disk_lmn[0] + ds_to_disk_lmn[1] * ds_to_disk_lmn[1]);
 
-  ds = (z1) / 100.;
-  ds += 1;                      // We must move it a little bit (in case z1 = 0) SS Aug 2004
-  move_phot (&phit, ds);        // Move the photon a bit more
-  r2 = sqrt (phit.x[0] * phit.x[0] + phit.x[1] * phit.x[1]);
-  z2 = zdisk (r2) - fabs (phit.x[2]);   // this is the function
+  dzds = (z < 0) ? -ds_to_disk_lmn[2] : ds_to_disk_lmn[2];
 
-  *value = z1;
-  *derivative = (z2 - z1) / ds;
+  *value = zdisk (r) - fabs (z);        // this is the function
+  *derivative = (r > 0 ? zdisk_slope (r) * drds : 0.0) - dzds;
 
 }
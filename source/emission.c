@@ -387,6 +387,7 @@ photo_gen_wind (p, weight, freqmin, freqmax, photstart, nphot)
   int photstop;
   double xlum, xlumsum, lum;
   double v[3];
+  double *wind_weight;
   int icell;
   int nplasma;
   int nnscat;
@@ -396,27 +397,23 @@ photo_gen_wind (p, weight, freqmin, freqmax, photstart, nphot)
   photstop = photstart + nphot;
   Log_silent ("photo_gen_wind creates nphot %5d photons from %5d to %5d \n", nphot, photstart, photstop);
 
-  for (n = photstart; n < photstop; n++)
+  /* Make an alias table from which to choose the cell in which each photon bundle originates.
+     Note: In photo_gen, geo.f_wind and plasmamain[].lum_rad will have been determined.  Due to the 
+     way wind_luminosity gets called, lum_rad is actually the band limited flux not the luminosity.
+     Only cells with volume greater than zero are considered. */
+
+  wind_weight = calloc (NDIM2, sizeof (double));
+  for (icell = 0; icell < NDIM2; icell++)
   {
-    /* locate the wind_cell in which the photon bundle originates.
-       Note: In photo_gen, both geo.f_wind and geo.lum_wind will have been determined.
-       geo.f_wind refers to the specific flux between freqmin and freqmax.  Note that
-       we make sure that xlum is not == 0 or to geo.f_wind. */
-    xlum = (rand () + 0.5) / (MAXRAND) * geo.f_wind;
+    if (wmain[icell].vol > 0.0)
+      wind_weight[icell] = plasmamain[wmain[icell].nplasma].lum_rad;
+  }
+  alias_gen (&alias_wind, wind_weight, NDIM2);
+  free (wind_weight);
 
-    xlumsum = 0;
-    icell = 0;
-    while (xlumsum < xlum)
-    {
-//?? 57+ This is not the best way to do this.  We should be able to sum over the plasma structure
-      if (wmain[icell].vol > 0.0)       //only consider cells with volume greater than zero
-      {
-        nplasma = wmain[icell].nplasma; //get the plasma cell in this wind cell
-        xlumsum += plasmamain[nplasma].lum_rad; /*increment the xlumsum by the lum_rad in this plasma cell - note that due to the way wind_luminosity gets called, this is actually the band limited flux not the luminosity. */
-      }
-      icell++;                  /*If we are not yet up to xlum, go to the next cell */
-    }
-    icell--;                    /* We have got up to xlum, so this is the cell in which the photon must be generated */
+  for (n = photstart; n < photstop; n++)
+  {
+    icell = alias_get_rand (&alias_wind);       /* This is the cell in which the photon must be generated */
 
     nplasma = wmain[icell].nplasma;
     ndom = wmain[icell].ndom;
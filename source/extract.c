@@ -6,6 +6,15 @@
 #include "atomic.h"
 #include "python.h"
 
+/* Tabulated optical depths from the wind cells to the observers, see extract_tau_table_init */
+
+float *xtau_table = NULL;       /* tau to escape, or -istat if the photon did not escape */
+int xtau_nspec, xtau_naz, xtau_nfreq;
+double xtau_lfmin, xtau_dlf;
+int xtau_check;                 /* Every xtau_check'th lookup is compared to the exact path */
+long xtau_nlookup, xtau_nexact;
+double xtau_err_sum, xtau_w_sum;
+
 /***********************************************************
                                        Space Telescope Science Institute
 
@@ -84,10 +93,21 @@ extract (w, p, itype)
   double xdiff[3];
   int ndom;
 
-
   /* 68b -09021 - ksl - The next line selects the middle inclination angle for recording the absorbed enery */
   phot_history_spectrum = 0.5 * (MSPEC + nspectra);
 
+  /* The velocity at the position of the photon is the same for every observer, so get it 
+     once here rather than once for each spectrum */
+
+  if (itype == PTYPE_DISK)
+    vdisk (p->x, v);
+  else if (itype == PTYPE_WIND)
+  {
+    ndom = wmain[p->grid].ndom;
+    stuff_phot (p, &pp);
+    vwind_xyz (ndom, &pp, v);
+  }
+
   for (n = MSPEC; n < nspectra; n++)
   {
     /* If statement allows one to choose whether to construct the spectrum
@@ -143,15 +163,12 @@ one is odd. We do frequency here but weighting is carried out in  extract */
 
       if (itype == PTYPE_DISK)
       {
-        vdisk (pp.x, v);
         doppler (p, &pp, v, -1);
 
       }
       if (itype == PTYPE_WIND)
       {                         /* If the photon was scattered in the wind, 
                                    the frequency also must be shifted */
-        ndom = wmain[p->grid].ndom;
-        vwind_xyz (ndom, &pp, v);       /*  Get the velocity at the position of pp */
         doppler (p, &pp, v, pp.nres);   /*  Doppler shift the photon -- test! */
 
 /*  Doppler shift the photon (as nonresonant scatter) to new direction */
@@ -226,6 +243,14 @@ with scattering processes, and the weight contains the effect of dimunition of t
 the photon bundle due to pure absorption processes.  So, in extract, we add pp->w * exp(-tau)
 to the spectrum.
 
+If geo.extract_rr_tau is greater than 0, Russian roulette is played each time tau passes
+another multiple of geo.extract_rr_tau.  The photon survives with probability
+exp(-geo.extract_rr_tau), and if it does its weight is increased by the inverse of this, so the
+spectrum is unbiased.  Since a surviving photon has been attenuated by at least as much as its
+weight has been increased, no extracted photon ever contributes more than its starting weight.
+Directions in which the wind is optically thick are then abandoned early, instead of being
+followed all the way to TAU_MAX.
+
 History:
  	97march ksl	Coded and debugged as part of Python effort.  
  	97july	ksl	Included the possibility that the photon was absorbed by the secondary.
@@ -256,6 +281,9 @@ extract_one (w, pp, itype, nspec)
   double dvds;
   double lfreqmin, lfreqmax, ldfreq;
   int ishell;
+  double tau_rr, p_survive;
+  int istat_tab, check_tab;
+  double tau_tab, w_tab, f_exact, f_tab;
 
 
   weight_min = EPSILON * pp->w;
@@ -340,13 +368,69 @@ the same resonance again */
     phot_hist (pp, 0);          // Initialize the photon history
   }
 
+/* If a table of optical depths to the observers has been built, use it in place of the 
+ * integration along the path.  Every xtau_check'th photon which could have used the table is 
+ * integrated exactly instead, and the two are compared to estimate the error in the table.
+ * The table is integrated from the cell centres at the photon frequency, so for a photon
+ * which has just been scattered or emitted in a line it would include the resonance the
+ * photon has already been moved past; these photons are always integrated exactly */
+
+  check_tab = 0;
+  istat_tab = -1;
+  tau_tab = w_tab = 0;
+  if (istat == P_INWIND && xtau_table != NULL && geo.ioniz_or_extract == 0 && pp->nres < 0
+      && (istat_tab = extract_tau_lookup (pp, nspec, &tau_tab)) >= 0)
+  {
+    if (xtau_check > 0 && (xtau_nlookup % xtau_check) == 0)
+    {
+      check_tab = 1;
+      w_tab = pp->w;
+    }
+    else
+    {
+      istat = istat_tab;
+      tau = tau_tab;
+    }
+    xtau_nlookup++;
+  }
+
 /* Now we can actually extract the reweighted photon */
 
+  if (geo.extract_rr_tau > 0)
+  {
+    tau_rr = geo.extract_rr_tau;
+    p_survive = exp (-geo.extract_rr_tau);
+  }
+  else
+  {
+    tau_rr = TAU_MAX;
+    p_survive = 1.0;
+  }
+
   while (istat == P_INWIND)
   {
-    istat = translate (w, pp, 20., &tau, &nres);
+    istat = translate (w, pp, (tau_rr < TAU_MAX) ? tau_rr : TAU_MAX, &tau, &nres);
     icell++;
 
+    if (istat == P_SCAT && tau_rr < TAU_MAX)
+    {
+      /* tau has passed the next roulette point */
+      if ((rand () + 0.5) / MAXRAND > p_survive)
+      {
+        istat = P_ABSORB;
+        break;
+      }
+      pp->w /= p_survive;
+      while (tau_rr <= tau)
+        tau_rr += geo.extract_rr_tau;
+
+      /* If we stopped at a resonance, move past it so it is not counted again */
+      pp->nres = nres;
+      reposition (pp);
+      istat = P_INWIND;
+      continue;
+    }
+
     istat = walls (pp, &pstart);
     if (istat == -1)
     {
@@ -374,6 +458,15 @@ the same resonance again */
     }
   }
 
+  if (check_tab)
+  {
+    f_exact = (istat == P_ESCAPE) ? pp->w * exp (-tau) : 0.0;
+    f_tab = (istat_tab == P_ESCAPE) ? w_tab * exp (-tau_tab) : 0.0;
+    xtau_err_sum += fabs (f_tab - f_exact);
+    xtau_w_sum += f_exact;
+    xtau_nexact++;
+  }
+
   if (istat == P_ESCAPE)
   {
 
@@ -387,13 +480,13 @@ the same resonance again */
 
       if (k < 0)
         k = 0;
-      else if (k > NWAVE - 1)
-        k = NWAVE - 1;
+      else if (k > xxspec[nspec].nwave - 1)
+        k = xxspec[nspec].nwave - 1;
 
 
       lfreqmin = log10 (xxspec[nspec].freqmin);
       lfreqmax = log10 (xxspec[nspec].freqmax);
-      ldfreq = (lfreqmax - lfreqmin) / NWAVE;
+      ldfreq = (lfreqmax - lfreqmin) / xxspec[nspec].nwave;
 
 
 
@@ -403,9 +496,9 @@ the same resonance again */
       {
         k1 = 0;
       }
-      if (k1 > NWAVE - 1)
+      if (k1 > xxspec[nspec].nwave - 1)
       {
-        k1 = NWAVE - 1;
+        k1 = xxspec[nspec].nwave - 1;
       }
 
       /* Increment the spectrum.  Note that the photon weight has not been diminished
@@ -435,7 +528,10 @@ the same resonance again */
         {                       //If this photon has scattered, been reprocessed, or originated in the wind it's important
           pstart.w = pp->w;     //Adjust weight to weight reduced by extraction
           //pp->path = pstart.path;
-          delay_dump_single (&pstart, 1);       //Dump photon now weight has been modified by extraction
+          if (geo.reverb_tf)    //Bin it straight into the transfer function with the weight used for the spectrum
+            reverb_tf_add (nspec - MSPEC, pp->freq, (delay_to_observer (&pstart) - geo.rmax) / C, pp->w * exp (-(tau)));
+          else
+            delay_dump_single (&pstart, 1);     //Dump photon now weight has been modified by extraction
         }
       }
 
@@ -466,3 +562,362 @@ the same resonance again */
 
   return (istat);
 }
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+int extract_tau_table_init (freqmin, freqmax) tabulates the optical depth 
+	from the center of every wind cell to each of the observers
+
+Arguments:		
+	double freqmin, freqmax		the frequency range of the detailed spectra
+
+Returns:
+ 
+	0 on success, -1 if the table could not be allocated
+ 
+Description:	
+
+In the spectral cycles the wind does not change, and so the optical depth
+from a point in the wind to an observer at a given frequency does not change
+either.  If geo.extract_tau_table is set, this routine integrates the optical 
+depth, continuum and Sobolev lines both, from the center of each cell that 
+is completely in the wind, for geo.extract_tau_naz azimuths about the z axis 
+and geo.extract_tau_nfreq frequencies equally spaced in log between freqmin 
+and freqmax.  extract_one then looks the optical depth up in the table rather 
+than integrating it for each photon.
+
+The table is only used for photons that were not scattered or emitted in a
+line (pp->nres < 0).  For those, the table would include the optical depth
+of the resonance which extract_one has already moved the photon past, and so
+they are still integrated exactly.  For the rest, the integration along the
+path is replaced by a lookup, and so the frequency resolution of the table 
+limits how well the line profiles are described.  To allow one to judge whether the table is good 
+enough, some photons are still integrated exactly, and extract_tau_table_report 
+logs the difference.
+
+Notes:
+
+The winds are axisymmetric, so the azimuth of the photon is folded into the
+table, and the observer phase is handled by the fact that each spectrum has
+its own entry.  For spherical domains, where a cell is a shell, the azimuths
+are replaced by bins in the cosine of the angle between the position and 
+the direction to the observer.
+
+With MPI, the cells are divided among the threads and the table is then
+summed over the threads, so every thread has the whole table.
+
+**************************************************************/
+
+int
+extract_tau_table_init (freqmin, freqmax)
+     double freqmin, freqmax;
+{
+  int n, nspec, k, i, istat;
+  long ntab, m;
+  double rho, phi, tau, mu;
+  double x[3], zaxis[3], perp[3];
+  struct photon p;
+
+  xtau_nspec = nspectra - MSPEC;
+  xtau_naz = geo.extract_tau_naz;
+  xtau_nfreq = geo.extract_tau_nfreq;
+  xtau_check = geo.extract_tau_check;
+  xtau_lfmin = log (freqmin);
+  xtau_dlf = (log (freqmax) - xtau_lfmin) / (xtau_nfreq - 1);
+
+  ntab = (long) NDIM2 *xtau_nspec * xtau_naz * xtau_nfreq;
+
+  if (xtau_table != NULL)
+    free (xtau_table);
+
+  if ((xtau_table = calloc (ntab, sizeof (float))) == NULL)
+  {
+    Error ("extract_tau_table_init: Could not allocate %ld entries for the table. Integrating paths instead\n", ntab);
+    return (-1);
+  }
+
+  Log ("extract_tau_table_init: Tabulating optical depths to %d observers, %d azimuths and %d frequencies\n",
+       xtau_nspec, xtau_naz, xtau_nfreq);
+
+  for (n = 0; n < NDIM2; n++)
+  {
+    if (wmain[n].inwind != W_ALL_INWIND)
+      continue;
+#ifdef MPI_ON
+    if (n % np_mpi_global != rank_global)
+      continue;
+#endif
+
+    rho = sqrt (wmain[n].xcen[0] * wmain[n].xcen[0] + wmain[n].xcen[1] * wmain[n].xcen[1]);
+
+    for (nspec = 0; nspec < xtau_nspec; nspec++)
+    {
+      if (zdom[wmain[n].ndom].coord_type == SPHERICAL)
+      {                         /* A direction perpendicular to the observer, to place the points at each mu */
+        zaxis[0] = zaxis[1] = 0;
+        zaxis[2] = 1;
+        cross (xxspec[nspec + MSPEC].lmn, zaxis, perp);
+        if (length (perp) < 1e-6)
+        {
+          zaxis[0] = 1;
+          zaxis[2] = 0;
+          cross (xxspec[nspec + MSPEC].lmn, zaxis, perp);
+        }
+        renorm (perp, 1.);
+      }
+
+      for (k = 0; k < xtau_naz; k++)
+      {
+        if (zdom[wmain[n].ndom].coord_type == SPHERICAL)
+        {                       /* Points at the centre of each bin in the cosine of the angle to the observer */
+          mu = -1. + 2. * (k + 0.5) / xtau_naz;
+          for (i = 0; i < 3; i++)
+            x[i] = wmain[n].rcen * (mu * xxspec[nspec + MSPEC].lmn[i] + sqrt (1. - mu * mu) * perp[i]);
+        }
+        else
+        {                       /* Points at each azimuth about the z axis */
+          phi = 2. * PI * k / xtau_naz;
+          x[0] = rho * cos (phi);
+          x[1] = rho * sin (phi);
+          x[2] = wmain[n].xcen[2];
+        }
+
+        for (i = 0; i < xtau_nfreq; i++)
+        {
+          stuff_v (x, p.x);
+          stuff_v (xxspec[nspec + MSPEC].lmn, p.lmn);
+          p.freq = p.freq_orig = exp (xtau_lfmin + i * xtau_dlf);
+          p.w = p.w_orig = 1.0;
+          p.tau = 0;
+          p.istat = P_INWIND;
+          p.nscat = p.nrscat = p.nnscat = 0;
+          p.nres = -1;
+          p.np = 0;
+          p.path = 0;
+          p.grid = n;
+          p.origin = PTYPE_WIND;
+
+          istat = extract_tau_path (wmain, &p, &tau);
+
+          m = (((long) n * xtau_nspec + nspec) * xtau_naz + k) * xtau_nfreq + i;
+          xtau_table[m] = (istat == P_ESCAPE) ? tau : -istat;
+        }
+      }
+    }
+  }
+
+#ifdef MPI_ON
+  /* Each entry has been calculated by exactly one thread, and is zero on the others */
+  MPI_Allreduce (MPI_IN_PLACE, xtau_table, ntab, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  xtau_nlookup = xtau_nexact = 0;
+  xtau_err_sum = xtau_w_sum = 0;
+
+  Log ("extract_tau_table_init: Finished table.  The elapsed TIME was %f\n", timer ());
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+int extract_tau_path (w, pp, tau) integrates the optical depth along the
+	path of pp until it leaves the wind, or tau exceeds TAU_MAX
+
+Arguments:		
+	WindPtr w;
+	PhotPtr pp;		the photon, which is moved along its path
+	double *tau		the optical depth accumulated along the path
+
+Returns:
+ 
+	The status of the photon at the end of the path, P_ESCAPE if 
+	it reached the observer
+ 
+Description:	
+
+This is the path integration of extract_one, without the reweighting 
+and Russian roulette.
+
+Notes:
+
+**************************************************************/
+
+int
+extract_tau_path (w, pp, tau)
+     WindPtr w;
+     PhotPtr pp;
+     double *tau;
+{
+  int istat, nres;
+  struct photon pstart;
+
+  stuff_phot (pp, &pstart);
+  *tau = 0;
+  istat = P_INWIND;
+
+  if (geo.binary == TRUE)
+    istat = hit_secondary (pp);
+
+  while (istat == P_INWIND)
+  {
+    translate (w, pp, TAU_MAX, tau, &nres);
+    istat = walls (pp, &pstart);
+    if (istat == -1)
+    {
+      Error ("extract_tau_path: Abnormal return from translate\n");
+      istat = P_ERROR;
+    }
+  }
+
+  return (istat);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+int extract_tau_lookup (pp, nspec, tau) finds the optical depth from the
+	position of pp to observer nspec in the table built by 
+	extract_tau_table_init
+
+Arguments:		
+	PhotPtr pp;		the photon, already shifted to the frequency it
+				has in the direction of the observer
+	int nspec		the spectrum
+	double *tau		the optical depth to the observer
+
+Returns:
+ 
+	P_ESCAPE if the photon reaches the observer, the status it ended
+	with if it does not, and -1 if the table cannot be used for this
+	photon
+ 
+Description:	
+
+The table is used only for photons in cells that are entirely in the 
+wind, and whose frequency lies within the range of the table.  The
+optical depth is taken from the nearest azimuth (or angle to the observer
+for spherical domains) and interpolated linearly
+in log frequency.  If either frequency point did not reach the observer, 
+the nearer one is used.
+
+Notes:
+
+**************************************************************/
+
+int
+extract_tau_lookup (pp, nspec, tau)
+     PhotPtr pp;
+     int nspec;
+     double *tau;
+{
+  int n, ndom, i, k;
+  long m;
+  double x, frac, phi, mu;
+  float a, b;
+
+  *tau = 0;
+
+  if (where_in_wind (pp->x, &ndom) != W_ALL_INWIND)
+    return (-1);
+  if ((n = where_in_grid (ndom, pp->x)) < 0 || wmain[n].inwind != W_ALL_INWIND)
+    return (-1);
+
+  x = (log (pp->freq) - xtau_lfmin) / xtau_dlf;
+  if (x < 0 || x > xtau_nfreq - 1)
+    return (-1);
+  i = x;
+  if (i > xtau_nfreq - 2)
+    i = xtau_nfreq - 2;
+  frac = x - i;
+
+  if (zdom[ndom].coord_type == SPHERICAL)
+  {
+    mu = dot (pp->x, xxspec[nspec].lmn) / length (pp->x);
+    k = (mu + 1.) / 2. * xtau_naz;
+    if (k > xtau_naz - 1)
+      k = xtau_naz - 1;
+  }
+  else
+  {
+    phi = atan2 (pp->x[1], pp->x[0]);
+    if (phi < 0)
+      phi += 2. * PI;
+    k = (int) (phi / (2. * PI) * xtau_naz + 0.5) % xtau_naz;
+  }
+
+  m = (((long) n * xtau_nspec + (nspec - MSPEC)) * xtau_naz + k) * xtau_nfreq + i;
+  a = xtau_table[m];
+  b = xtau_table[m + 1];
+
+  if (a >= 0 && b >= 0)
+  {
+    *tau = a + (b - a) * frac;
+    return (P_ESCAPE);
+  }
+
+  a = (frac < 0.5) ? a : b;
+  if (a >= 0)
+  {
+    *tau = a;
+    return (P_ESCAPE);
+  }
+  return ((int) (-a));
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+
+int extract_tau_table_report () logs how well the table of optical depths 
+	reproduced the photons that were also integrated exactly, and resets
+	the counters
+
+Arguments:		
+
+Returns:
+ 
+Description:	
+
+The error is the sum of the absolute differences between the weights 
+that the table and the exact integration would have added to the 
+spectra, divided by the sum of the exact weights.
+
+Notes:
+
+**************************************************************/
+
+int
+extract_tau_table_report ()
+{
+  if (xtau_table == NULL)
+    return (0);
+
+  if (xtau_nexact > 0 && xtau_w_sum > 0)
+    Log ("extract_tau_table_report: %ld lookups, %ld checked exactly, fractional error in extracted weight %.3e\n",
+         xtau_nlookup, xtau_nexact, xtau_err_sum / xtau_w_sum);
+  else
+    Log ("extract_tau_table_report: %ld lookups, none checked exactly\n", xtau_nlookup);
+
+  xtau_nlookup = xtau_nexact = 0;
+  xtau_err_sum = xtau_w_sum = 0;
+
+  return (0);
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "atomic.h"
 #include "log.h"
@@ -152,6 +153,15 @@ History:
 #define LINELENGTH 400
 #define MAXWORDS    20
 
+/* Hash tables used while the data is being read to find the configurations with a given (z, istate, ilv)
+   and the lines with a given (z, istate, levl, levu), see config_hash_find and line_hash_find.  Each
+   bucket is a chain of indices into config[] or line[] in the order the records were read */
+
+#define NCONFIG_HASH	NLEVELS
+#define NLINE_HASH	NLINES
+int *config_hash_head, *config_hash_tail, *config_hash_next;
+int *line_hash_head, *line_hash_tail, *line_hash_next;
+
 int
 get_atomic_data (masterfile)
      char masterfile[];
@@ -185,6 +195,9 @@ get_atomic_data (masterfile)
   char choice;
   int lineno;                   /* the line number in the file beginning with 1 */
   int index_collisions (), index_lines (), index_phot_top (), index_inner_cross (), index_phot_verner (), check_xsections ();
+  unsigned long long atomic_cache_key ();
+  int atomic_cache_read (), atomic_cache_write ();
+  int atomic_hash_init (), atomic_hash_free (), config_hash_add (), config_hash_find (), line_hash_add (), line_hash_find ();
   int nwords;
   int nlte, nmax;
   //  
@@ -221,6 +234,7 @@ get_atomic_data (masterfile)
   int c_l, c_u;                 //Chianti level indicators
   double en, gf, hlt, sp;       //Parameters in collision strangth file
   int type;                     //used in collision strength
+  unsigned long long cache_key; //hash of the input files, used to validate the binary cache
 
   /* define which files to read as data files */
 
@@ -549,8 +563,32 @@ structure does not have this property! */
 
 /* Completed all initialization */
 
+  /* If a binary cache of exactly these input files exists, load it instead of parsing the
+     text files, and just rebuild the frequency ordered pointers.  The summary in data.out
+     and the Evaluation messages are only produced when the text files are parsed, so the
+     cache is not read when write_atomicdata is set */
+
+  cache_key = 0;
+  if (atomic_cache)
+  {
+    cache_key = atomic_cache_key (masterfile);
+    if ((atomic_cache & ATOMIC_CACHE_READ) && !write_atomicdata && atomic_cache_read (masterfile, cache_key) == 0)
+    {
+      index_lines ();
+      index_collisions ();
+      if (ntop_phot + nxphot > 0)
+        index_phot_top ();
+      if (n_inner_tot > 0)
+        index_inner_cross ();
+      check_xsections ();
+      return (0);
+    }
+  }
+
   /* OK now we can try to read in the data from the data files */
 
+  atomic_hash_init ();
+
   if ((mptr = fopen (masterfile, "r")) == NULL)
   {
     Error ("Get_atomic_data:  Could not open masterfile %s\n", masterfile);
@@ -1065,6 +1103,7 @@ is already incremented
 
 
 
+          config_hash_add (nlevels);
           nlevels++;
 
           if (nlevels > NLEVELS)
@@ -1185,6 +1224,7 @@ described as macro-levels. */
           config[nlevels].rad_rate = 0.0;       // ?? Set emission oscillator strength for the level to zero
 
           nlevels_simple++;
+          config_hash_add (nlevels);
           nlevels++;
           if (nlevels > NLEVELS)
           {
@@ -1292,11 +1332,8 @@ for the ionstate.
             }
 
             // Locate upper state
-            n = 0;
-            while ((config[n].z != z || config[n].istate != (istate + 1)        //note that the upper config will (SS)
-                    || config[n].ilv != levu) && n < nlevels)   //be the next ion up (istate +1) (SS)
-              n++;
-            if (n == nlevels)
+            n = config_hash_find (z, istate + 1, levu, -1);     //note that the upper config will be the next ion up (istate +1) (SS)
+            if (n < 0)
             {
               Error_silent ("get_atomic_data: No configuration found to match upper state for phot. line %d\n", lineno);
               break;            //Need to match the configuration for macro atoms - break if not found.
@@ -1304,11 +1341,8 @@ for the ionstate.
 
 
             // Locate lower state
-            m = 0;
-            while ((config[m].z != z || config[m].istate != istate      //Now searching for the lower 
-                    || config[m].ilv != levl) && m < nlevels)   //configuration (SS)
-              m++;
-            if (m == nlevels)
+            m = config_hash_find (z, istate, levl, -1); //Now searching for the lower configuration (SS)
+            if (m < 0)
             {
               Error_silent ("get_atomic_data: No configuration found to match lower state for phot. line %d\n", lineno);
               break;            //Need to match the configuration for macro atoms - break if not found.
@@ -1405,7 +1439,6 @@ for the ionstate.
 
             }
 
-            n = 0;
 
 
             /* 080812 - 63 - ksl - added additional check to assure that records were
@@ -1414,10 +1447,10 @@ for the ionstate.
              * partition functions 
              */
 
-            while ((config[n].nden == -1
-                    || config[n].z != z || config[n].istate != istate || config[n].isp != islp || config[n].ilv != ilv) && n < nlevels)
-              n++;
-            if (n == nlevels)
+            n = config_hash_find (z, istate, ilv, -1);
+            while (n >= 0 && (config[n].nden == -1 || config[n].isp != islp))
+              n = config_hash_find (z, istate, ilv, n);
+            if (n < 0)
             {
               Debug ("No level found to match PhotTop data in file %s on line %d. Data ignored.\n", file, lineno);
               break;            // There was no pre-existing ion
@@ -1829,20 +1862,16 @@ Col
             el = EV2ERGS * el;
             eu = EV2ERGS * eu;
             //need to identify the configurations associated with the upper and lower levels (SS)
-            n = 0;
-            while ((config[n].z != z || config[n].istate != istate || config[n].ilv != levl) && n < nlevels)
-              n++;
-            if (n == nlevels)
+            n = config_hash_find (z, istate, levl, -1);
+            if (n < 0)
             {
               Error_silent ("Get_atomic_data: No configuration found to match lower level of line %d\n", lineno);
               break;
             }
 
 
-            m = 0;
-            while ((config[m].z != z || config[m].istate != istate || config[m].ilv != levu) && m < nlevels)
-              m++;
-            if (m == nlevels)
+            m = config_hash_find (z, istate, levu, -1);
+            if (m < 0)
             {
               Error_silent ("Get_atomic_data: No configuration found to match upper level of line %d\n", lineno);
               break;
@@ -1977,6 +2006,7 @@ would like to have simple lines for macro-ions */
                 line[nlines].macro_info = 1;    //It's a macro line
                 nlines_macro++;
               }
+              line_hash_add (nlines);
               nlines++;
             }
           }
@@ -2523,10 +2553,9 @@ BAD_T_RR  5  0  1  1  4.647E-10  0.7484  6.142E+01  1.753E+07*/
             Error ("Get_atomic_data: %s\n", aline);
             exit (0);
           }
-          for (n = 0; n < nlines; n++)  //loop over all the lines we have read in - look for a match
+          for (n = line_hash_find (z, istate, levl, levu, -1); n >= 0; n = line_hash_find (z, istate, levl, levu, n))      //loop over the lines we have read in with the same levels - look for a match
           {
-            if (line[n].z == z && line[n].istate == istate && line[n].levl == levl && line[n].levu == levu && line[n].gl == gl
-                && line[n].gu == gu && line[n].f == f)
+            if (line[n].gl == gl && line[n].gu == gu && line[n].f == f)
             {
               if (line[n].coll_index > -1)      //We already have a collision strength record from this line - throw an error and quit
               {
@@ -2603,6 +2632,7 @@ BAD_T_RR  5  0  1  1  4.647E-10  0.7484  6.142E+01  1.753E+07*/
  */
 
   fclose (mptr);
+  atomic_hash_free ();
 /* OK now summarize the data that has been read*/
 
   n_elec_yield_tot = 0;         //Reset this numnber, we are now going to use it to check we have yields for all inner shells
@@ -2704,7 +2734,7 @@ a total emission oscillator strength for the level....really ought to be radiati
       mstop = mstart + ion[line[n].nion].nlevels;
 
       m = mstart;
-      while (config[m].ilv != line[n].levl && m < mstop)
+      while (m < mstop && config[m].ilv != line[n].levl)
         m++;
       if (m < mstop)
         line[n].nconfigl = m;
@@ -2712,7 +2742,7 @@ a total emission oscillator strength for the level....really ought to be radiati
         line[n].nconfigl = -9999;
 
       m = mstart;
-      while (config[m].ilv != line[n].levu && m < mstop)
+      while (m < mstop && config[m].ilv != line[n].levu)
         m++;
       if (m < mstop)
       {
@@ -2866,6 +2896,10 @@ or zero so that simple checks of true and false can be used for them */
     fclose (fptr);
   }                             // end of if statement based on modes.write_atomicdata
 
+  /* Save what has been read so that the next run with the same data files can skip the parsing */
+  if (atomic_cache & ATOMIC_CACHE_WRITE)
+    atomic_cache_write (masterfile, cache_key);
+
 
 
   /* Finally create frequency ordered pointers to the various portions
@@ -2898,6 +2932,586 @@ or zero so that simple checks of true and false can be used for them */
   return (0);
 }
 
+/**************************************************************************
+
+
+  Synopsis:
+	The next set of routines maintain the hash tables which get_atomic_data
+	uses to match records in the data files to configurations and lines
+	which have already been read in.
+
+  Description:
+	config_hash_add and line_hash_add are called as each configuration
+	or line is stored.  config_hash_find (z, istate, ilv, n) and
+	line_hash_find (z, istate, levl, levu, n) return the first matching
+	configuration or line after n, or the first one if n < 0, and -1
+	when there are no more.  The matches are returned in the order in
+	which they were read, so the first match is the same one the linear
+	searches used to find.
+
+  Arguments:
+
+  Returns:
+
+  Notes:
+	Previously each photoionization, macro-atom line and collision
+	strength record searched all of the configurations or lines read so
+	far, which made reading a large data set quadratic in its size.
+
+	The tables only exist while the data files are being read.
+
+  History:
+
+ ************************************************************************/
+
+int
+atomic_hash_init ()
+{
+  int n;
+  int atomic_hash_free ();
+
+  atomic_hash_free ();
+
+  config_hash_head = calloc (sizeof (int), NCONFIG_HASH);
+  config_hash_tail = calloc (sizeof (int), NCONFIG_HASH);
+  config_hash_next = calloc (sizeof (int), NLEVELS + 1);
+  line_hash_head = calloc (sizeof (int), NLINE_HASH);
+  line_hash_tail = calloc (sizeof (int), NLINE_HASH);
+  line_hash_next = calloc (sizeof (int), NLINES + 1);
+
+  if (config_hash_head == NULL || config_hash_tail == NULL || config_hash_next == NULL
+      || line_hash_head == NULL || line_hash_tail == NULL || line_hash_next == NULL)
+  {
+    Error ("atomic_hash_init: There is a problem in allocating memory for the atomic data hash tables\n");
+    exit (0);
+  }
+
+  for (n = 0; n < NCONFIG_HASH; n++)
+    config_hash_head[n] = config_hash_tail[n] = -1;
+  for (n = 0; n < NLINE_HASH; n++)
+    line_hash_head[n] = line_hash_tail[n] = -1;
+
+  return (0);
+}
+
+
+int
+atomic_hash_free ()
+{
+  free (config_hash_head);
+  free (config_hash_tail);
+  free (config_hash_next);
+  free (line_hash_head);
+  free (line_hash_tail);
+  free (line_hash_next);
+
+  config_hash_head = config_hash_tail = config_hash_next = NULL;
+  line_hash_head = line_hash_tail = line_hash_next = NULL;
+
+  return (0);
+}
+
+
+/* atomic_hash combines up to four integers into a bucket number */
+
+int
+atomic_hash (i1, i2, i3, i4, nbuckets)
+     int i1, i2, i3, i4, nbuckets;
+{
+  unsigned int h;
+
+  h = (unsigned int) i1;
+  h = h * 1000003u + (unsigned int) i2;
+  h = h * 1000003u + (unsigned int) i3;
+  h = h * 1000003u + (unsigned int) i4;
+  h ^= h >> 16;
+
+  return (h % nbuckets);
+}
+
+
+int
+config_hash_add (n)
+     int n;
+{
+  int ib;
+
+  if (n >= NLEVELS)
+    return (-1);
+
+  ib = atomic_hash (config[n].z, config[n].istate, config[n].ilv, 0, NCONFIG_HASH);
+  config_hash_next[n] = -1;
+  if (config_hash_tail[ib] < 0)
+    config_hash_head[ib] = n;
+  else
+    config_hash_next[config_hash_tail[ib]] = n;
+  config_hash_tail[ib] = n;
+
+  return (0);
+}
+
+
+int
+config_hash_find (z, istate, ilv, n)
+     int z, istate, ilv, n;
+{
+  if (n < 0)
+    n = config_hash_head[atomic_hash (z, istate, ilv, 0, NCONFIG_HASH)];
+  else
+    n = config_hash_next[n];
+
+  while (n >= 0 && (config[n].z != z || config[n].istate != istate || config[n].ilv != ilv))
+    n = config_hash_next[n];
+
+  return (n);
+}
+
+
+int
+line_hash_add (n)
+     int n;
+{
+  int ib;
+
+  if (n >= NLINES)
+    return (-1);
+
+  ib = atomic_hash (line[n].z, line[n].istate, line[n].levl, line[n].levu, NLINE_HASH);
+  line_hash_next[n] = -1;
+  if (line_hash_tail[ib] < 0)
+    line_hash_head[ib] = n;
+  else
+    line_hash_next[line_hash_tail[ib]] = n;
+  line_hash_tail[ib] = n;
+
+  return (0);
+}
+
+
+int
+line_hash_find (z, istate, levl, levu, n)
+     int z, istate, levl, levu, n;
+{
+  if (n < 0)
+    n = line_hash_head[atomic_hash (z, istate, levl, levu, NLINE_HASH)];
+  else
+    n = line_hash_next[n];
+
+  while (n >= 0 && (line[n].z != z || line[n].istate != istate || line[n].levl != levl || line[n].levu != levu))
+    n = line_hash_next[n];
+
+  return (n);
+}
+
+
+/**************************************************************************
+
+
+  Synopsis:
+	The next set of routines atomic_cache_... maintain a binary copy of
+	the atomic data which get_atomic_data has built, so that later runs
+	with the same data files can skip parsing the text files.
+
+  Description:
+	The cache is written to the file masterfile.cache.  It consists
+	of an Atomic_cache_head followed by the used portions of each of
+	the atomic data arrays.  The pointer arrays (lin_ptr, phot_top_ptr
+	etc) are not stored; get_atomic_data rebuilds them with the
+	index_ routines after the cache is loaded.
+
+	The cache is only used if its key matches the one computed from the
+	current inputs.  The key is an FNV-1a hash of the sizes of the
+	structures and arrays in atomic.h, the date this file was compiled,
+	and the contents of the masterfile and every data file it names.
+	Editing any of the data files, or rebuilding the program, therefore
+	causes the cache to be rebuilt.
+
+  Arguments:
+
+  Returns:
+	atomic_cache_read and atomic_cache_write return 0 on success and
+	-1 if the cache could not be used or written, in which case
+	get_atomic_data simply parses the data files as usual.
+
+  Notes:
+	The cache is read with a single fread into a buffer before anything
+	is copied into the atomic data arrays, so a stale or truncated cache
+	leaves the arrays in their initialized state.
+
+	The cache is written to a temporary file which is then renamed, so
+	that other processes never see a partially written cache.  In
+	parallel mode only the master process should set ATOMIC_CACHE_WRITE.
+
+	The cache is not read when write_atomicdata is set, since data.out
+	is written while the text files are parsed.
+
+  History:
+
+ ************************************************************************/
+
+#define FNV_OFFSET	14695981039346656037ULL
+#define FNV_PRIME	1099511628211ULL
+#define ATOMIC_CACHE_MAGIC "PYATOM1"
+#define ATOMIC_CACHE_NBLOCKS 18
+
+/* atomic_cache_key calculates the key for the cache from the masterfile and the files it names */
+
+unsigned long long
+atomic_cache_key (masterfile)
+     char masterfile[];
+{
+  FILE *mptr;
+  char aline[LINELENGTH], file[LINELENGTH];
+  unsigned long long key;
+  unsigned char *c;
+  int sizes[20];
+  unsigned int n;
+  unsigned long long atomic_cache_hash_file ();
+
+  sizes[0] = sizeof (ele_dummy);
+  sizes[1] = sizeof (ion_dummy);
+  sizes[2] = sizeof (config_dummy);
+  sizes[3] = sizeof (line_dummy);
+  sizes[4] = sizeof (Coll_stren);
+  sizes[5] = sizeof (Topbase_phot);
+  sizes[6] = sizeof (Inner_elec_yield);
+  sizes[7] = sizeof (Inner_fluor_yield);
+  sizes[8] = sizeof (Innershell);
+  sizes[9] = sizeof (struct ground_fracs);
+  sizes[10] = sizeof (struct collision_strength);
+  sizes[11] = sizeof (Drecomb);
+  sizes[12] = sizeof (Cpart);
+  sizes[13] = sizeof (Total_rr);
+  sizes[14] = sizeof (Bad_gs_rr);
+  sizes[15] = sizeof (Dere_di_rate);
+  sizes[16] = sizeof (Gaunt_total);
+  sizes[17] = NLEVELS;
+  sizes[18] = NLINES;
+  sizes[19] = NIONS;
+
+  key = FNV_OFFSET;
+  c = (unsigned char *) sizes;
+  for (n = 0; n < sizeof (sizes); n++)
+  {
+    key ^= c[n];
+    key *= FNV_PRIME;
+  }
+
+  c = (unsigned char *) __DATE__ __TIME__;
+  for (n = 0; c[n] != '\0'; n++)
+  {
+    key ^= c[n];
+    key *= FNV_PRIME;
+  }
+
+  key = atomic_cache_hash_file (masterfile, key);
+
+  if ((mptr = fopen (masterfile, "r")) == NULL)
+  {
+    return (key);
+  }
+
+  while (fgets (aline, LINELENGTH, mptr) != NULL)
+  {
+    if (sscanf (aline, "%s", file) == 1 && file[0] != '#')
+    {
+      key = atomic_cache_hash_file (file, key);
+    }
+  }
+  fclose (mptr);
+
+  /* get_atomic_data may also read the Verner cross sections directly */
+  key = atomic_cache_hash_file ("atomic/photo_verner.data", key);
+
+  return (key);
+}
+
+
+
+/* atomic_cache_hash_file adds the contents of a file to the key.  A missing file changes the
+   key in a different way to an empty one, so the cache cannot outlive a deleted data file */
+
+unsigned long long
+atomic_cache_hash_file (filename, key)
+     char filename[];
+     unsigned long long key;
+{
+  FILE *fptr;
+  unsigned char buf[65536];
+  size_t nread, n;
+
+  if ((fptr = fopen (filename, "r")) == NULL)
+  {
+    key ^= 0xff;
+    key *= FNV_PRIME;
+    return (key);
+  }
+
+  while ((nread = fread (buf, 1, sizeof (buf), fptr)) > 0)
+  {
+    for (n = 0; n < nread; n++)
+    {
+      key ^= buf[n];
+      key *= FNV_PRIME;
+    }
+  }
+  fclose (fptr);
+
+  key ^= 0xfe;
+  key *= FNV_PRIME;
+
+  return (key);
+}
+
+
+
+/* atomic_cache_blocks lists the arrays stored in the cache, in the order they are stored, along with
+   the size of one element and the number of elements used according to the counts in head */
+
+int
+atomic_cache_blocks (head, ptr, size, count)
+     Atomic_cache_headPtr head;
+     void *ptr[];
+     size_t size[];
+     int count[];
+{
+  int n;
+
+  n = 0;
+  ptr[n] = ele;
+  size[n] = sizeof (ele_dummy);
+  count[n++] = head->nelements;
+  ptr[n] = ion;
+  size[n] = sizeof (ion_dummy);
+  count[n++] = head->nions;
+  ptr[n] = config;
+  size[n] = sizeof (config_dummy);
+  count[n++] = head->nlevels;
+  ptr[n] = line;
+  size[n] = sizeof (line_dummy);
+  count[n++] = head->nlines;
+  ptr[n] = coll_stren;
+  size[n] = sizeof (Coll_stren);
+  count[n++] = head->n_coll_stren;
+
+  /* phot_top is filled up to nphot_total for VFKY ground state cross sections as well */
+  ptr[n] = phot_top;
+  size[n] = sizeof (Topbase_phot);
+  count[n++] = head->nphot_total > head->ntop_phot + head->nxphot ? head->nphot_total : head->ntop_phot + head->nxphot;
+  ptr[n] = inner_cross;
+  size[n] = sizeof (Topbase_phot);
+  count[n++] = head->n_inner_tot;
+
+  /* The remaining arrays are small, or are filled without a global count, so are stored whole */
+  ptr[n] = inner_elec_yield;
+  size[n] = sizeof (Inner_elec_yield);
+  count[n++] = N_INNER * NIONS;
+  ptr[n] = inner_fluor_yield;
+  size[n] = sizeof (Inner_fluor_yield);
+  count[n++] = N_INNER * NIONS;
+  ptr[n] = augerion;
+  size[n] = sizeof (Innershell);
+  count[n++] = NAUGER;
+  ptr[n] = ground_frac;
+  size[n] = sizeof (struct ground_fracs);
+  count[n++] = NIONS;
+  ptr[n] = xcol;
+  size[n] = sizeof (struct collision_strength);
+  count[n++] = NTRANS;
+  ptr[n] = drecomb;
+  size[n] = sizeof (Drecomb);
+  count[n++] = NIONS;
+  ptr[n] = cpart;
+  size[n] = sizeof (Cpart);
+  count[n++] = NIONS;
+  ptr[n] = total_rr;
+  size[n] = sizeof (Total_rr);
+  count[n++] = NIONS;
+  ptr[n] = bad_gs_rr;
+  size[n] = sizeof (Bad_gs_rr);
+  count[n++] = NIONS;
+  ptr[n] = dere_di_rate;
+  size[n] = sizeof (Dere_di_rate);
+  count[n++] = NIONS;
+  ptr[n] = gaunt_total;
+  size[n] = sizeof (Gaunt_total);
+  count[n++] = MAX_GAUNT_N_GSQRD;
+
+  return (n);
+}
+
+
+
+/* atomic_cache_read loads the atomic data from the cache if it matches key */
+
+int
+atomic_cache_read (masterfile, key)
+     char masterfile[];
+     unsigned long long key;
+{
+  FILE *fptr;
+  char cachefile[LINELENGTH];
+  Atomic_cache_head head;
+  void *ptr[ATOMIC_CACHE_NBLOCKS];
+  size_t size[ATOMIC_CACHE_NBLOCKS];
+  int count[ATOMIC_CACHE_NBLOCKS];
+  char *buf, *b;
+  long nbytes;
+  int n, nblocks;
+  int atomic_cache_blocks ();
+
+  sprintf (cachefile, "%s.cache", masterfile);
+
+  if ((fptr = fopen (cachefile, "rb")) == NULL)
+  {
+    return (-1);
+  }
+
+  if (fread (&head, sizeof (head), 1, fptr) != 1 || strncmp (head.magic, ATOMIC_CACHE_MAGIC, 8) != 0 || head.key != key)
+  {
+    Log ("get_atomic_data: The cache %s is out of date and will be rebuilt\n", cachefile);
+    fclose (fptr);
+    return (-1);
+  }
+
+  nblocks = atomic_cache_blocks (&head, ptr, size, count);
+  nbytes = 0;
+  for (n = 0; n < nblocks; n++)
+    nbytes += size[n] * count[n];
+
+  if (nbytes != head.nbytes || (buf = malloc (nbytes)) == NULL)
+  {
+    fclose (fptr);
+    return (-1);
+  }
+
+  if (fread (buf, 1, nbytes, fptr) != (size_t) nbytes)
+  {
+    Error ("get_atomic_data: The cache %s is truncated and will be rebuilt\n", cachefile);
+    free (buf);
+    fclose (fptr);
+    return (-1);
+  }
+  fclose (fptr);
+
+  b = buf;
+  for (n = 0; n < nblocks; n++)
+  {
+    memcpy (ptr[n], b, size[n] * count[n]);
+    b += size[n] * count[n];
+  }
+  free (buf);
+
+  nelements = head.nelements;
+  nions = head.nions;
+  nlevels = head.nlevels;
+  nlte_levels = head.nlte_levels;
+  nlevels_macro = head.nlevels_macro;
+  nlines = head.nlines;
+  nlines_macro = head.nlines_macro;
+  n_inner_tot = head.n_inner_tot;
+  nauger = head.nauger;
+  n_coll_stren = head.n_coll_stren;
+  nxphot = head.nxphot;
+  ntop_phot = head.ntop_phot;
+  nphot_total = head.nphot_total;
+  nxcol = head.nxcol;
+  ndrecomb = head.ndrecomb;
+  ncpart = head.ncpart;
+  n_total_rr = head.n_total_rr;
+  n_bad_gs_rr = head.n_bad_gs_rr;
+  n_dere_di_rate = head.n_dere_di_rate;
+  gaunt_n_gsqrd = head.gaunt_n_gsqrd;
+  phot_freq_min = head.phot_freq_min;
+  inner_freq_min = head.inner_freq_min;
+  rho2nh = head.rho2nh;
+
+  Log ("get_atomic_data: Read %d elements, %d ions, %d levels and %d lines from the cache %s\n",
+       nelements, nions, nlevels, nlines, cachefile);
+
+  return (0);
+}
+
+
+
+/* atomic_cache_write saves the atomic data which has just been read in to the cache */
+
+int
+atomic_cache_write (masterfile, key)
+     char masterfile[];
+     unsigned long long key;
+{
+  FILE *fptr;
+  char cachefile[LINELENGTH], tmpfile[LINELENGTH];
+  Atomic_cache_head head;
+  void *ptr[ATOMIC_CACHE_NBLOCKS];
+  size_t size[ATOMIC_CACHE_NBLOCKS];
+  int count[ATOMIC_CACHE_NBLOCKS];
+  int n, nblocks, ierr;
+  int atomic_cache_blocks ();
+
+  memset (&head, 0, sizeof (head));
+  strcpy (head.magic, ATOMIC_CACHE_MAGIC);
+  head.key = key;
+  head.nelements = nelements;
+  head.nions = nions;
+  head.nlevels = nlevels;
+  head.nlte_levels = nlte_levels;
+  head.nlevels_macro = nlevels_macro;
+  head.nlines = nlines;
+  head.nlines_macro = nlines_macro;
+  head.n_inner_tot = n_inner_tot;
+  head.nauger = nauger;
+  head.n_coll_stren = n_coll_stren;
+  head.nxphot = nxphot;
+  head.ntop_phot = ntop_phot;
+  head.nphot_total = nphot_total;
+  head.nxcol = nxcol;
+  head.ndrecomb = ndrecomb;
+  head.ncpart = ncpart;
+  head.n_total_rr = n_total_rr;
+  head.n_bad_gs_rr = n_bad_gs_rr;
+  head.n_dere_di_rate = n_dere_di_rate;
+  head.gaunt_n_gsqrd = gaunt_n_gsqrd;
+  head.phot_freq_min = phot_freq_min;
+  head.inner_freq_min = inner_freq_min;
+  head.rho2nh = rho2nh;
+
+  nblocks = atomic_cache_blocks (&head, ptr, size, count);
+  head.nbytes = 0;
+  for (n = 0; n < nblocks; n++)
+    head.nbytes += size[n] * count[n];
+
+  sprintf (cachefile, "%s.cache", masterfile);
+  sprintf (tmpfile, "%s.cache.%d", masterfile, getpid ());
+
+  /* Not being able to write the cache, for example in a read-only data directory, is not an error */
+  if ((fptr = fopen (tmpfile, "wb")) == NULL)
+  {
+    Log_silent ("get_atomic_data: Could not open %s, so the atomic data will not be cached\n", tmpfile);
+    return (-1);
+  }
+
+  ierr = fwrite (&head, sizeof (head), 1, fptr) != 1;
+  for (n = 0; n < nblocks; n++)
+  {
+    if (count[n] > 0 && fwrite (ptr[n], size[n], count[n], fptr) != (size_t) count[n])
+      ierr = 1;
+  }
+
+  if (fclose (fptr) != 0 || ierr || rename (tmpfile, cachefile) != 0)
+  {
+    Log_silent ("get_atomic_data: Could not write %s, so the atomic data will not be cached\n", cachefile);
+    remove (tmpfile);
+    return (-1);
+  }
+
+  Log ("get_atomic_data: Saved the atomic data to the cache %s\n", cachefile);
+
+  return (0);
+}
+
+
 /**************************************************************************
                     Space Telescope Science Institute
                                                                                                    
@@ -128,8 +128,9 @@ get_models (modellist, npars, spectype)
   char dummy[LINELENGTH];
   int n, m, mm, nxpar;
   double xpar[NPARS], xmin[NPARS], xmax[NPARS];
-  int get_one_model ();
-  int nw, nwaves;
+  int get_one_model (), model_grid_init ();
+  int nw, nwaves, j;
+  double *w, *f;
 
 
   nwaves = 0;
@@ -138,6 +139,8 @@ get_models (modellist, npars, spectype)
   {
     nmods_tot = 0;
     ncomps = 0;                 // The number of different sets of models that have been read in
+    nmods_alloc = 0;
+    mods = NULL;
     get_models_init = 1;
   }
 
@@ -180,6 +183,15 @@ get_models (modellist, npars, spectype)
     comp[ncomps].xmod.par[m] = -99;
   }
 
+  /* Models are read into these buffers, and then only as much as is needed is kept */
+  w = calloc (NWAVES, sizeof (double));
+  f = calloc (NWAVES, sizeof (double));
+  if (w == NULL || f == NULL)
+  {
+    Error ("get_models: Could not allocate buffers to read models\n");
+    exit (0);
+  }
+
   nw = -1;                      // Initiallize nw
   while (n < NMODS && (fgets (dummy, LINELENGTH, mptr)) != NULL)
   {
@@ -188,6 +200,15 @@ get_models (modellist, npars, spectype)
     }                           //skip comment lines in models
     else
     {
+      if (n >= nmods_alloc)
+      {
+        nmods_alloc += 100;
+        if ((mods = realloc (mods, nmods_alloc * sizeof (struct Model))) == NULL)
+        {
+          Error ("get_models: Could not allocate space for %d models\n", nmods_alloc);
+          exit (0);
+        }
+      }
       nxpar =
         sscanf (dummy, "%s %lf %lf %lf %lf %lf %lf %lf %lf %lf",
                 mods[n].name, &xpar[0], &xpar[1], &xpar[2], &xpar[3], &xpar[4], &xpar[5], &xpar[6], &xpar[7], &xpar[8]);
@@ -208,13 +229,37 @@ get_models (modellist, npars, spectype)
       for (mm = m; mm < NPARS; mm++)
         mods[n].par[mm] = -99;
 
-      nwaves = get_one_model (mods[n].name, &mods[n]);
+      nwaves = get_one_model (mods[n].name, w, f);
       if (nw > 0 && nwaves != nw)
       {
         Error ("get_models: file %s has %d wavelengths, others have %d\n", mods[n].name, nwaves, nw);
         exit (0);
       }
 
+      /* The first model of a component supplies the wavelengths for all of them */
+      if (nw < 0)
+      {
+        nw = nwaves;
+        comp[ncomps].xmod.w = calloc (nwaves, sizeof (double));
+        comp[ncomps].xmod.f = calloc (nwaves, sizeof (double));
+        if (comp[ncomps].xmod.w == NULL || comp[ncomps].xmod.f == NULL)
+        {
+          Error ("get_models: Could not allocate %d wavelengths for %s\n", nwaves, modellist);
+          exit (0);
+        }
+        for (j = 0; j < nwaves; j++)
+          comp[ncomps].xmod.w[j] = w[j];
+      }
+
+      if ((mods[n].f = calloc (nwaves, sizeof (float))) == NULL)
+      {
+        Error ("get_models: Could not allocate %d wavelengths for model %s\n", nwaves, mods[n].name);
+        exit (0);
+      }
+      for (j = 0; j < nwaves; j++)
+        mods[n].f[j] = f[j];
+      mods[n].nwaves = nwaves;
+
       if ((n % 100) == 0)
         Log ("Model n %d %s\n", n, mods[n].name);
       n++;
@@ -230,10 +275,9 @@ get_models (modellist, npars, spectype)
   comp[ncomps].modstop = nmods_tot = n;
   comp[ncomps].nmods = comp[ncomps].modstop - comp[ncomps].modstart;
   comp[ncomps].nwaves = nwaves;
-  for (n = 0; n < nwaves; n++)
-  {
-    comp[ncomps].xmod.w[n] = mods[comp[ncomps].modstart].w[n];
-  }
+
+  free (w);
+  free (f);
 
   if (comp[ncomps].nmods == 0)
   {
@@ -253,22 +297,25 @@ get_models (modellist, npars, spectype)
     comp[ncomps].max[m] = xmax[m];
   }
 
+  model_grid_init (ncomps);
+
   *spectype = ncomps;           // Set the spectype 
   ncomps++;
   return (*spectype);
 }
 
 /* Get a single model model 
-   This routine simple reads a model file from disk and puts the result into the structure
-   onemod.  This file need not have the same wavelengths as the data nor other models.
+   This routine simple reads a model file from disk and puts the result into the arrays
+   xw and xf, which must have room for NWAVES elements.  This file need not have the same 
+   wavelengths as the data nor other models.
 
 080915  ksl     Added error to catch the case where the model being read in has more
                 wavelengths than allowed, ie. more than NWAVES
  */
 int
-get_one_model (filename, onemod)
+get_one_model (filename, xw, xf)
      char filename[];
-     struct Model *onemod;
+     double xw[], xf[];
 {
   FILE *ptr;
   char dummy[LINELEN];
@@ -286,13 +333,12 @@ get_one_model (filename, onemod)
     if ((dummy[0] != '#'))
     {
       sscanf (dummy, "%le %le", &w, &f);
-      onemod->w[n] = w;
-      onemod->f[n] = f;
+      xw[n] = w;
+      xf[n] = f;
 
       n++;
     }
   }
-  onemod->nwaves = n;
 
 
   if (n >= NWAVES)
@@ -366,13 +412,14 @@ model (spectype, par)
 {
   int j, n;
   int good_models[NMODS];       // Used to establish which models are to be included in creating output model
+  int model_vertices (), model_cache_find (), model_cache_store ();
   double xmin[NPARS], xmax[NPARS];      // The vertices of a completely filled grid
   double weight[NMODS];         // The weights assigned to the models
   double hi, lo, delta, wtot;
   int ngood;
   double f;
   int nwaves;
-  double flux[NWAVES];
+  double *flux;
   double q1, q2, lambda, tscale, xxx;   // Used for rescaleing according to a bb
 
 
@@ -390,6 +437,13 @@ exact model previously */
     return (0);                 // This was the model stored in comp already
   }
 
+  /* Next see if it is one of the models interpolated recently */
+
+  if (model_cache_find (spectype, par) >= 0)
+  {
+    return (comp[spectype].nwaves);
+  }
+
 
   /* First identify the models of interest */
   n = 0;
@@ -409,55 +463,65 @@ exact model previously */
     n++;
   }
 
-  for (j = 0; j < comp[spectype].npars; j++)
+  /* If the grid is completely filled, the models which bracket par can be found directly.
+     Otherwise, the models are searched, one parameter at a time */
+
+  if (comp[spectype].vertex != NULL)
   {
-    xmax[j] = comp[spectype].max[j];
-    xmin[j] = comp[spectype].min[j];
-    hi = BIG;
-    lo = -BIG;
-    for (n = comp[spectype].modstart; n < comp[spectype].modstop; n++)
+    model_vertices (spectype, par, good_models, weight);
+  }
+  else
+  {
+    for (j = 0; j < comp[spectype].npars; j++)
     {
-      if (good_models[n])
+      xmax[j] = comp[spectype].max[j];
+      xmin[j] = comp[spectype].min[j];
+      hi = BIG;
+      lo = -BIG;
+      for (n = comp[spectype].modstart; n < comp[spectype].modstop; n++)
       {
-        delta = mods[n].par[j] - par[j];
-        if (delta > 0.0 && delta < hi)
-        {
-          xmax[j] = mods[n].par[j];
-          hi = delta;
-        }
-        if (delta <= 0.0 && delta >= lo)
+        if (good_models[n])
         {
-          xmin[j] = mods[n].par[j];
-          lo = delta;
+          delta = mods[n].par[j] - par[j];
+          if (delta > 0.0 && delta < hi)
+          {
+            xmax[j] = mods[n].par[j];
+            hi = delta;
+          }
+          if (delta <= 0.0 && delta >= lo)
+          {
+            xmin[j] = mods[n].par[j];
+            lo = delta;
+          }
         }
       }
-    }
-    // So at this point we know what xmin[j] and xmax[j] and we 
-    // need to prune good_models
-    for (n = comp[spectype].modstart; n < comp[spectype].modstop; n++)
-    {
-      // Next lines excludes the models which are out of range.
-      if (mods[n].par[j] > xmax[j] || mods[n].par[j] < xmin[j])
-        good_models[n] = 0;
-      // Next line modifies the weight of this model assuming a regular grid
-      // If xmax==xmin, then par[j] was outside of the range of the models and
-      // so we need to weight the remaining models fully.
-      if (good_models[n] && xmax[j] > xmin[j])
+      // So at this point we know what xmin[j] and xmax[j] and we 
+      // need to prune good_models
+      for (n = comp[spectype].modstart; n < comp[spectype].modstop; n++)
       {
-        f = (par[j] - xmin[j]) / (xmax[j] - xmin[j]);
-        if (mods[n].par[j] == xmax[j])
+        // Next lines excludes the models which are out of range.
+        if (mods[n].par[j] > xmax[j] || mods[n].par[j] < xmin[j])
+          good_models[n] = 0;
+        // Next line modifies the weight of this model assuming a regular grid
+        // If xmax==xmin, then par[j] was outside of the range of the models and
+        // so we need to weight the remaining models fully.
+        if (good_models[n] && xmax[j] > xmin[j])
         {
-          // Then the model is at the maximum for this parameter
-          weight[n] *= f;
-        }
-        else
-          weight[n] *= (1. - f);
+          f = (par[j] - xmin[j]) / (xmax[j] - xmin[j]);
+          if (mods[n].par[j] == xmax[j])
+          {
+            // Then the model is at the maximum for this parameter
+            weight[n] *= f;
+          }
+          else
+            weight[n] *= (1. - f);
 
 /* 57g -- If the weight given to a model is going to be zero, it needs to be
 excluded from furthur consideration -- 07jul ksl */
-        if (weight[n] == 0.0)
-          good_models[n] = 0;
+          if (weight[n] == 0.0)
+            good_models[n] = 0;
 
+        }
       }
     }
   }
@@ -508,7 +572,8 @@ excluded from furthur consideration -- 07jul ksl */
 
   nwaves = comp[spectype].nwaves;
 
-// Now create the spectrum 
+// Now create the spectrum, directly in comp[spectype].xmod
+  flux = comp[spectype].xmod.f;
   for (j = 0; j < nwaves; j++)
   {
     flux[j] = 0;
@@ -591,16 +656,351 @@ even, and so for those cases we want to make sure to calculate the ratio of qs d
 
 
 
-/* End of section to reweight the spectra. we can now copy fluxes to structure */
+/* End of section to reweight the spectra. The fluxes are already in the structure */
 
-  for (j = 0; j < nwaves; j++)
-  {
-    comp[spectype].xmod.f[j] = flux[j];
-  }
   for (j = 0; j < comp[spectype].npars; j++)
   {
     comp[spectype].xmod.par[j] = par[j];
   }
 
+  model_cache_store (spectype);
+
   return (nwaves);
 }
+
+
+
+/**************************************************************************
+                    Space Telescope Science Institute
+
+
+  Synopsis:  model_grid_init records the distinct values of each parameter 
+  	of a component, and if the models fill the grid these values define, 
+	which model lies at each vertex of the grid
+
+  Description:	
+
+  Arguments:		
+  	int spectype	the component
+
+  Returns:
+  	The number of vertices if the grid is completely filled, 0 otherwise
+
+  Notes:
+
+  If the grid is completely filled, model uses the vertices to find the 
+  models which bracket the parameters it is given, rather than searching 
+  all of the models.  For a filled grid the two give the same models and
+  weights.  For a grid with missing models (or duplicates), the search 
+  is still used, since the pruning it carries out depends on which models 
+  exist.
+
+ ************************************************************************/
+
+int
+model_grid_init (spectype)
+     int spectype;
+{
+  int j, k, n, m, nvert, npars;
+  double x;
+  double *values;
+  struct ModSum *one;
+
+  one = &comp[spectype];
+  npars = one->npars;
+
+  values = calloc (one->nmods, sizeof (double));
+
+  /* Find the distinct values of each parameter, in increasing order */
+
+  nvert = 1;
+  for (j = 0; j < npars; j++)
+  {
+    one->naxis[j] = 0;
+    for (n = one->modstart; n < one->modstop; n++)
+    {
+      x = mods[n].par[j];
+      k = one->naxis[j];
+      while (k > 0 && values[k - 1] > x)
+        k--;
+      if (k > 0 && values[k - 1] == x)
+        continue;
+      for (m = one->naxis[j]; m > k; m--)
+        values[m] = values[m - 1];
+      values[k] = x;
+      one->naxis[j]++;
+    }
+    one->axis[j] = calloc (one->naxis[j], sizeof (double));
+    for (k = 0; k < one->naxis[j]; k++)
+      one->axis[j][k] = values[k];
+    nvert *= one->naxis[j];
+  }
+  free (values);
+
+  /* Now place each model on the grid */
+
+  one->vertex = NULL;
+  if (nvert != one->nmods)
+  {
+    Log ("model_grid_init: %s has %d models for %d grid points, so models will be searched\n", one->name, one->nmods, nvert);
+    return (0);
+  }
+
+  one->vertex = calloc (nvert, sizeof (int));
+  for (k = 0; k < nvert; k++)
+    one->vertex[k] = -1;
+
+  for (n = one->modstart; n < one->modstop; n++)
+  {
+    k = 0;
+    for (j = npars - 1; j >= 0; j--)
+    {
+      m = 0;
+      while (one->axis[j][m] != mods[n].par[j])
+        m++;
+      k = k * one->naxis[j] + m;
+    }
+    if (one->vertex[k] >= 0)
+    {
+      Log ("model_grid_init: %s has more than one model at a grid point, so models will be searched\n", one->name);
+      free (one->vertex);
+      one->vertex = NULL;
+      return (0);
+    }
+    one->vertex[k] = n;
+  }
+
+  return (nvert);
+}
+
+
+
+/**************************************************************************
+                    Space Telescope Science Institute
+
+
+  Synopsis:  model_vertices finds the models at the vertices of the grid cell 
+  	containing par, and their weights for bi-linear (or multi-linear)
+	interpolation
+
+  Description:	
+
+  Arguments:		
+  	int spectype	the component, which must have a completely filled grid
+	double par[]	the parameters of the desired model
+	int good_models[]	set to 1 for the models to be used, and 0 for the
+			other models of the component
+	double weight[]	the weights of the models to be used
+
+  Returns:
+  	The number of models to be used
+
+  Notes:
+
+  This reproduces the bracketing of the search in model.  In each parameter the
+  bracketing values are the largest grid value <= par and the smallest grid value
+  > par.  Outside the grid both are the value at the edge, and the parameter 
+  does not affect the weights.  Models whose weight is 0 are not used.
+
+ ************************************************************************/
+
+int
+model_vertices (spectype, par, good_models, weight)
+     int spectype;
+     double par[];
+     int good_models[];
+     double weight[];
+{
+  int j, n, c, k, ngood, npars;
+  int ilo[NPARS], ihi[NPARS];
+  double f[NPARS], w;
+  int lo, hi, mid;
+  struct ModSum *one;
+
+  one = &comp[spectype];
+  npars = one->npars;
+
+  for (n = one->modstart; n < one->modstop; n++)
+  {
+    weight[n] = good_models[n] = 0;
+  }
+
+  for (j = 0; j < npars; j++)
+  {
+    if (par[j] < one->axis[j][0])
+    {
+      ilo[j] = ihi[j] = 0;
+    }
+    else if (par[j] >= one->axis[j][one->naxis[j] - 1])
+    {
+      ilo[j] = ihi[j] = one->naxis[j] - 1;
+    }
+    else
+    {
+      lo = 0;
+      hi = one->naxis[j] - 1;
+      while (hi - lo > 1)
+      {
+        mid = (lo + hi) / 2;
+        if (one->axis[j][mid] <= par[j])
+          lo = mid;
+        else
+          hi = mid;
+      }
+      ilo[j] = lo;
+      ihi[j] = hi;
+    }
+    if (ihi[j] > ilo[j])
+      f[j] = (par[j] - one->axis[j][ilo[j]]) / (one->axis[j][ihi[j]] - one->axis[j][ilo[j]]);
+    else
+      f[j] = 0;
+  }
+
+  /* Go through the corners of the cell.  Bit j of c selects the upper value of parameter j */
+
+  ngood = 0;
+  for (c = 0; c < (1 << npars); c++)
+  {
+    w = 1;
+    k = 0;
+    for (j = npars - 1; j >= 0; j--)
+    {
+      if (c & (1 << j))
+      {
+        if (ihi[j] == ilo[j])
+          break;
+        w *= f[j];
+        k = k * one->naxis[j] + ihi[j];
+      }
+      else
+      {
+        if (ihi[j] > ilo[j])
+          w *= (1. - f[j]);
+        k = k * one->naxis[j] + ilo[j];
+      }
+    }
+    if (j >= 0 || w == 0.0)
+      continue;                 // Not a distinct corner, or one which does not contribute
+
+    n = one->vertex[k];
+    good_models[n] = 1;
+    weight[n] = w;
+    ngood++;
+  }
+
+  return (ngood);
+}
+
+
+
+/**************************************************************************
+                    Space Telescope Science Institute
+
+
+  Synopsis:  model_cache_find looks for par among the models of a component
+  	that were interpolated recently, and if it is there copies it
+	to comp[spectype].xmod
+
+  Description:	
+
+  Arguments:		
+  	int spectype	the component
+	double par[]	the parameters of the desired model
+
+  Returns:
+  	The entry in the cache, or -1 if par was not there
+
+  Notes:
+
+  Sources which alternate between a few models, for example the star and
+  the disk drawing from the same grid, would otherwise cause the model to be
+  interpolated again at each change.  The cache holds NMODCACHE models per
+  component, and model_cache_store replaces the least recently used one.
+
+ ************************************************************************/
+
+int
+model_cache_find (spectype, par)
+     int spectype;
+     double par[];
+{
+  int i, j;
+  struct ModSum *one;
+
+  one = &comp[spectype];
+
+  for (i = 0; i < NMODCACHE; i++)
+  {
+    if (one->cache_used[i] == 0)
+      continue;
+    j = 0;
+    while (j < one->npars && one->cache_par[i][j] == par[j])
+      j++;
+    if (j == one->npars)
+    {
+      for (j = 0; j < one->nwaves; j++)
+        one->xmod.f[j] = one->cache_f[i][j];
+      for (j = 0; j < one->npars; j++)
+        one->xmod.par[j] = par[j];
+      one->cache_used[i] = ++one->cache_clock;
+      return (i);
+    }
+  }
+
+  return (-1);
+}
+
+
+
+/**************************************************************************
+                    Space Telescope Science Institute
+
+
+  Synopsis:  model_cache_store adds the model in comp[spectype].xmod to the
+  	cache of recently interpolated models
+
+  Description:	
+
+  Arguments:		
+  	int spectype	the component
+
+  Returns:
+  	The entry in the cache that was used
+
+  Notes:
+
+ ************************************************************************/
+
+int
+model_cache_store (spectype)
+     int spectype;
+{
+  int i, j, iold;
+  struct ModSum *one;
+
+  one = &comp[spectype];
+
+  iold = 0;
+  for (i = 1; i < NMODCACHE; i++)
+  {
+    if (one->cache_used[i] < one->cache_used[iold])
+      iold = i;
+  }
+
+  if (one->cache_f[iold] == NULL)
+  {
+    if ((one->cache_f[iold] = calloc (one->nwaves, sizeof (double))) == NULL)
+    {
+      Error ("model_cache_store: Could not allocate space for %d wavelengths\n", one->nwaves);
+      return (-1);
+    }
+  }
+
+  for (j = 0; j < one->nwaves; j++)
+    one->cache_f[iold][j] = one->xmod.f[j];
+  for (j = 0; j < one->npars; j++)
+    one->cache_par[iold][j] = one->xmod.par[j];
+  one->cache_used[iold] = ++one->cache_clock;
+
+  return (iold);
+}
@@ -6,6 +6,7 @@ double hydro_r_edge[MAXHYDRO];
 double hydro_theta_cent[MAXHYDRO];
 double hydro_theta_edge[MAXHYDRO];
 int ihydro_r, ihydro_theta, j_hydro_thetamax, ihydro_mod;
+int hydro_ntheta_read;          //The number of theta values in the hydro file, before truncation at hydro_thetamax
 double hydro_thetamax;          //The angle at which we want to truncate the theta grid
 double v_r_input[MAXHYDRO * MAXHYDRO];
 double v_theta_input[MAXHYDRO * MAXHYDRO];
@@ -317,6 +318,7 @@ get_hydro (ndom)
   }
 
   ihydro_r = irmax;
+  hydro_ntheta_read = ithetamax + 1;
 
   Log ("Read %d r values\n", ihydro_r);
   Log ("Read %d theta values\n", ihydro_theta);
@@ -901,6 +903,7 @@ hydro_restart (ndom)
     model_velocity (ndom, w[n].x, w[n].v);
     model_vgrad (ndom, w[n].x, w[n].v_grad);
   }
+  vwind_coef_ok = FALSE;        // The velocities have changed
 
   /* JM XXX PLACEHOLDER -- unsure how we loop over the plasma cells just in one domain */
   for (n = 0; n < NPLASMA; n++)
@@ -910,6 +913,7 @@ hydro_restart (ndom)
     old_density = plasmamain[n].rho;
     plasmamain[n].rho = model_rho (ndom, x) / zdom[ndom].fill;
     plasmamain[n].t_r = plasmamain[n].t_e = hydro_temp (x);
+    plasmamain[n].ncycles_converged = 0;        // The cell has changed, so it is no longer converged
 
     for (nion = 0; nion < nions; nion++)        //Change the absolute number densities, fractions remain the same
     {
@@ -930,3 +934,71 @@ hydro_restart (ndom)
   return (0);
 
 }
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	hydro_update replaces the density, temperature and velocities
+	read from the hydro file with new values for the same grid
+
+ Arguments:
+	nr, ntheta	the number of radial and theta cells in the new data,
+			which must be the same as in the original hydro file
+	values		5 arrays of nr*ntheta values, one after the other,
+			containing rho, temp, v_r, v_theta and v_phi.  Each
+			array is ordered with theta varying fastest, as in
+			the hydro file
+
+ Returns:
+	0 on success, -1 if the grid does not match the hydro file
+
+ Description:
+	This is used by the zeus server mode, where new hydro data arrives
+	over a fifo rather than in a file.  As in get_hydro, the densities
+	of cells beyond hydro_thetamax are replaced by the last density
+	above the disk.  hydro_restart should be called afterwards to
+	propagate the new values to the wind and plasma structures.
+
+ Notes:
+
+ History:
+
+**************************************************************/
+
+int
+hydro_update (nr, ntheta, values)
+     int nr, ntheta;
+     double values[];
+{
+  int i, j, n, ncells;
+
+  if (nr != ihydro_r + 1 || ntheta != hydro_ntheta_read)
+  {
+    Error ("hydro_update: New hydro grid %d x %d does not match the grid %d x %d in the hydro file\n",
+           nr, ntheta, ihydro_r + 1, hydro_ntheta_read);
+    return (-1);
+  }
+
+  ncells = nr * ntheta;
+
+  for (i = 0; i < nr; i++)
+  {
+    for (j = 0; j < ntheta; j++)
+    {
+      n = i * ntheta + j;
+      if (j > 0 && hydro_theta_edge[j] > hydro_thetamax && hydro_theta_edge[j - 1] > hydro_thetamax)
+        rho_input[i * MAXHYDRO + j] = rho_input[i * MAXHYDRO + j_hydro_thetamax];
+      else
+        rho_input[i * MAXHYDRO + j] = values[n];
+      temp_input[i * MAXHYDRO + j] = values[ncells + n];
+      v_r_input[i * MAXHYDRO + j] = values[2 * ncells + n];
+      v_theta_input[i * MAXHYDRO + j] = values[3 * ncells + n];
+      v_phi_input[i * MAXHYDRO + j] = values[4 * ncells + n];
+    }
+  }
+
+  return (0);
+}
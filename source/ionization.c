@@ -480,6 +480,14 @@ meaning in nebular concentrations.
 
    xxxplasma is just a way to tranmit information to zero_emit
 
+   Every call to zero_emit recalculates all of the cooling in the cell, so the number of calls
+   is what sets the cost of this routine.  The search starts from the current t_e (pushed on by
+   dt_e if the temperature has been moving the same way for two cycles) and is improved with
+   secant steps.  Once two points bracket the zero, steps which would leave the bracket are
+   replaced by bisection.  The ends of the interval are only evaluated if the search runs into
+   them, so for a cell that is nearly in equilibrium only two or three calls are needed.  The
+   calls are counted in nte_solve_calls and nte_solve_evals, which wind_update reports.
+
    History:
 
    98dec        ksl     Updated calls so that tmin and tmax were communicated externally,
@@ -496,45 +504,134 @@ meaning in nebular concentrations.
 	06may	ksl	Modified for plasma structue
  */
 
+#define TE_TOL        50.       /* Accuracy in K to which t_e is found (the old zbrent tolerance) */
+#define TE_FIRST_STEP 0.02      /* Fractional size of the first step, before there is a secant */
+#define TE_MAXITER    40
+
 
 double
 calc_te (xplasma, tmin, tmax)
      PlasmaPtr xplasma;
      double tmin, tmax;
 {
-  double z1, z2;
+  double t, z, t_last, z_last, t_next;
+  double t_pos, t_neg, z_tmin, z_tmax;
+  int have_pos, have_neg, have_tmin, have_tmax;
+  int niter, converged;
   int macro_pops ();
 
 
   /* 110916 - ksl - Note that we assign a plasma pointer here to a fixed structure because
-   * we need to call zbrent and we cannot pass the xplasma ptr directly
+   * we need to call zero_emit and we cannot pass the xplasma ptr directly
    */
 
   xxxplasma = xplasma;
+  nte_solve_calls++;
 
+  have_pos = have_neg = have_tmin = have_tmax = converged = 0;
+  t_pos = t_neg = z_tmin = z_tmax = 0.0;
 
-  xplasma->t_e = tmin;
-  z1 = zero_emit (tmin);
-  xplasma->t_e = tmax;
-  z2 = zero_emit (tmax);
+  /* Warm start from the current temperature */
 
-  /* The way this works is that if we have a situation where the cooling
-   * at tmax and tmin brackets the heating, then we use zbrent to improve
-   * the estimated temperature, but if not we chose the best direction
-   */
+  t = xplasma->t_e;
+  if (xplasma->dt_e * xplasma->dt_e_old > 0.0)
+    t += xplasma->dt_e;
+  if (t < tmin || t > tmax)
+    t = 0.5 * (tmin + tmax);
+
+  z = te_eval (t, tmin, tmax, &have_tmin, &z_tmin, &have_tmax, &z_tmax);
+  t_last = t;
+  z_last = z;
+
+  for (niter = 0; niter < TE_MAXITER; niter++)
+  {
+    if (z == 0.0)
+    {
+      converged = 1;
+      break;
+    }
+
+    if (z > 0.0)
+    {
+      t_pos = t;
+      have_pos = 1;
+    }
+    else
+    {
+      t_neg = t;
+      have_neg = 1;
+    }
+
+    if (have_pos && have_neg && fabs (t_pos - t_neg) < TE_TOL)
+    {
+      converged = 1;
+      break;
+    }
+
+    /* Choose the next point.  Heating minus cooling generally falls with temperature,
+     * so if the secant is not defined move towards the end where the sign should change */
+
+    if (niter == 0)
+      t_next = t * (1. + TE_FIRST_STEP);
+    else if (z != z_last)
+      t_next = t - z * (t - t_last) / (z - z_last);
+    else if (z > 0.0)
+      t_next = tmax;
+    else
+      t_next = tmin;
+
+    if (have_pos && have_neg)
+    {
+      if ((t_next - t_pos) * (t_next - t_neg) >= 0.0)
+        t_next = 0.5 * (t_pos + t_neg);
+    }
+    else if (t_next <= tmin)
+    {
+      if (have_tmin)
+        break;
+      t_next = tmin;
+    }
+    else if (t_next >= tmax)
+    {
+      if (have_tmax)
+        break;
+      t_next = tmax;
+    }
+
+    if (niter > 0 && fabs (t_next - t) < 0.5 * TE_TOL)
+    {
+      converged = 1;
+      break;
+    }
 
-  if ((z1 * z2 < 0.0))
-  {                             // Then the interval is bracketed 
-    xplasma->t_e = zbrent (zero_emit, tmin, tmax, 50.);
+    t_last = t;
+    z_last = z;
+    t = t_next;
+    z = te_eval (t, tmin, tmax, &have_tmin, &z_tmin, &have_tmax, &z_tmax);
   }
-  else if (fabs (z1) < fabs (z2))
+
+  if (converged || (have_pos && have_neg))
   {
-    xplasma->t_e = tmin;
+    if (!converged)
+      Error ("calc_te: no convergence in %d steps, t_e %8.2e between %8.2e and %8.2e\n", TE_MAXITER, t, t_pos, t_neg);
+    xplasma->t_e = t;
   }
   else
   {
-    xplasma->t_e = tmax;
+    /* Heating and cooling do not balance anywhere we looked, so as before
+     * choose whichever end of the interval comes closest */
+
+    if (!have_tmin)
+      te_eval (tmin, tmin, tmax, &have_tmin, &z_tmin, &have_tmax, &z_tmax);
+    if (!have_tmax)
+      te_eval (tmax, tmin, tmax, &have_tmin, &z_tmin, &have_tmax, &z_tmax);
+
+    if (fabs (z_tmin) < fabs (z_tmax))
+      xplasma->t_e = tmin;
+    else
+      xplasma->t_e = tmax;
   }
+
   /* With the new temperature in place for the cell, get the correct value of heat_tot.
      SS June  04 */
 
@@ -559,6 +656,41 @@ calc_te (xplasma, tmin, tmax)
 
 }
 
+#undef TE_TOL
+#undef TE_FIRST_STEP
+#undef TE_MAXITER
+
+
+
+/* te_eval is used by calc_te to call zero_emit.  It counts the calls and remembers
+   the result if t is one of the ends of the interval, so that no end is evaluated twice. */
+
+double
+te_eval (t, tmin, tmax, have_tmin, z_tmin, have_tmax, z_tmax)
+     double t, tmin, tmax;
+     int *have_tmin, *have_tmax;
+     double *z_tmin, *z_tmax;
+{
+  double z;
+
+  xxxplasma->t_e = t;
+  z = zero_emit (t);
+  nte_solve_evals++;
+
+  if (t == tmin)
+  {
+    *have_tmin = 1;
+    *z_tmin = z;
+  }
+  else if (t == tmax)
+  {
+    *have_tmax = 1;
+    *z_tmax = z;
+  }
+
+  return (z);
+}
+
 
 
 /* This is just a function which has a zero when total energy loss is equal to total energy gain */
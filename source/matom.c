@@ -401,6 +401,8 @@ matom (p, nres, escape)
   /* When is gets here either the sum has reached maxjumps: didn't find an emission: this is
      an error and stops the run OR an emission mechanism has been chosen in which case all is well. SS */
 
+  perf_count[PERF_MATOM_JUMPS] += njumps;
+
   if (njumps == MAXJUMPS)
   {
     Error ("Matom: jumped %d times with no emission. Abort.\n", MAXJUMPS);
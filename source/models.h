@@ -17,8 +17,9 @@
 #define NDIM	10              // The maximum number of free parameters
 #define NCOMPS	10              //The maximum number of separate components
 #define NPARS	10              //The maximum number of parameters in a component (not all variable)
-#define NMODS   1000            //The total number of models read in in all components
+#define NMODS   1000            //The maximum number of models read in in all components
 #define LINELEN 160             //This should always be the same as LINELENGTH in python.h!
+#define NMODCACHE 8             //The number of interpolated models remembered for each component
 
 
 //#include      "pdf.h"
@@ -28,17 +29,29 @@ int nmods_tot;                  // The total number of models that have been rea
 
 
 /* This is the structure that describes an individual continuum model. 
- * mods is the set of all models that are read
+ * mods is the set of all models that are read.  Only the fluxes are stored 
+ * for each model, as floats, and only for as many wavelengths as were read.  
+ * All of the models of a component share the wavelengths stored in comp[].xmod.w.
+ * mods is allocated, and extended, by get_models as models are read in.
  */
 struct Model
 {
   char name[LINELEN];
   double par[NPARS];
-  double w[NWAVES];
-  double f[NWAVES];
+  float *f;                     // The fluxes, allocated to nwaves
   int nwaves;
 }
-mods[NMODS];
+ *mods;
+
+int nmods_alloc;                // The number of elements of mods that have been allocated
+
+/* The interpolated model of a component, which is used to generate photons */
+struct XModel
+{
+  double par[NPARS];
+  double *w;                    // The wavelengths, allocated to comp[].nwaves
+  double *f;                    // The interpolated fluxes, allocated to comp[].nwaves
+};
 
 /* There is one element of comp for each set of models of the same type, i.e. if
 one reads in a list of WD atmosphers this will occupy one componenet here */
@@ -51,8 +64,19 @@ struct ModSum
   double min[NPARS];            // The minimum and maximum for each "free" paratmenter of the model
   double max[NPARS];
   int nwaves;                   //All models in each comp should have same wavelengths;
-  struct Model xmod;            //The current intepolated model of this type 
+  struct XModel xmod;           //The current intepolated model of this type 
   struct Pdf xpdf;              //The current cumulative distribution function for this component
+
+  /* The grid topology, made by model_grid_init when the models are read in */
+  int naxis[NPARS];             // The number of distinct values of each parameter
+  double *axis[NPARS];          // The distinct values of each parameter in increasing order
+  int *vertex;                  // The model at each vertex of the grid, NULL unless the grid is completely filled
+
+  /* A small cache of the most recently interpolated models, see model() */
+  double *cache_f[NMODCACHE];
+  double cache_par[NMODCACHE][NPARS];
+  long cache_used[NMODCACHE];   // When each entry was last used, 0 if it is empty
+  long cache_clock;
 }
 comp[NCOMPS];
 
@@ -273,9 +273,6 @@ communicate_estimators_para ()
 Synopsis: gather_spectra_para
 
 Arguments:	
-  int nspec_helper
-    size of the helper arrays used by the MPI_Reduce and Broadcast routines
-
   int nspecs
     the number of spectra computed. This is longer for the spectral cycles than
     the ionization cycles 	
@@ -293,41 +290,43 @@ History:
 
 
 int
-gather_spectra_para (nspec_helper, nspecs)
-     int nspec_helper;
+gather_spectra_para (nspecs)
      int nspecs;
 {
 #ifdef MPI_ON                   // these routines should only be called anyway in parallel but we need these to compile
 
   double *redhelper, *redhelper2;
-  int mpi_i, mpi_j;
+  int mpi_i, mpi_j, nwave, nspec_helper;
+
+  /* All four arrays of each spectrum are gathered in a single reduction */
+  nwave = xxspec[0].nwave;
+  nspec_helper = 4 * nwave * nspecs;
 
   redhelper = calloc (sizeof (double), nspec_helper);
   redhelper2 = calloc (sizeof (double), nspec_helper);
 
 
-  for (mpi_i = 0; mpi_i < NWAVE; mpi_i++)
+  for (mpi_j = 0; mpi_j < nspecs; mpi_j++)
   {
-    for (mpi_j = 0; mpi_j < nspecs; mpi_j++)
+    for (mpi_i = 0; mpi_i < nwave; mpi_i++)
     {
-      redhelper[mpi_i * nspecs + mpi_j] = xxspec[mpi_j].f[mpi_i] / np_mpi_global;
-
-      if (geo.ioniz_or_extract) // this is True in ionization cycles only, when we also have a log_spec_tot file
-        redhelper[mpi_i * nspecs + mpi_j + (NWAVE * nspecs)] = xxspec[mpi_j].lf[mpi_i] / np_mpi_global;
+      redhelper[(4 * mpi_j) * nwave + mpi_i] = xxspec[mpi_j].f[mpi_i] / np_mpi_global;
+      redhelper[(4 * mpi_j + 1) * nwave + mpi_i] = xxspec[mpi_j].lf[mpi_i] / np_mpi_global;
+      redhelper[(4 * mpi_j + 2) * nwave + mpi_i] = xxspec[mpi_j].f_wind[mpi_i] / np_mpi_global;
+      redhelper[(4 * mpi_j + 3) * nwave + mpi_i] = xxspec[mpi_j].lf_wind[mpi_i] / np_mpi_global;
     }
   }
 
-  MPI_Reduce (redhelper, redhelper2, nspec_helper, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-  MPI_Bcast (redhelper2, nspec_helper, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Allreduce (redhelper, redhelper2, nspec_helper, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
 
-  for (mpi_i = 0; mpi_i < NWAVE; mpi_i++)
+  for (mpi_j = 0; mpi_j < nspecs; mpi_j++)
   {
-    for (mpi_j = 0; mpi_j < nspecs; mpi_j++)
+    for (mpi_i = 0; mpi_i < nwave; mpi_i++)
     {
-      xxspec[mpi_j].f[mpi_i] = redhelper2[mpi_i * nspecs + mpi_j];
-
-      if (geo.ioniz_or_extract) // this is True in ionization cycles only, when we also have a log_spec_tot file
-        xxspec[mpi_j].lf[mpi_i] = redhelper2[mpi_i * nspecs + mpi_j + (NWAVE * nspecs)];
+      xxspec[mpi_j].f[mpi_i] = redhelper2[(4 * mpi_j) * nwave + mpi_i];
+      xxspec[mpi_j].lf[mpi_i] = redhelper2[(4 * mpi_j + 1) * nwave + mpi_i];
+      xxspec[mpi_j].f_wind[mpi_i] = redhelper2[(4 * mpi_j + 2) * nwave + mpi_i];
+      xxspec[mpi_j].lf_wind[mpi_i] = redhelper2[(4 * mpi_j + 3) * nwave + mpi_i];
     }
   }
   MPI_Barrier (MPI_COMM_WORLD);
@@ -341,6 +340,303 @@ gather_spectra_para (nspec_helper, nspecs)
 
 
 
+/***********************************************************
+                        University of Southampton
+
+Synopsis: gather_tf_para
+
+Arguments:	
+
+Returns:
+ 
+Description:	
+  Averages the reverberation transfer function between tasks,
+  in the same way as gather_spectra_para does the spectra, so
+  that every task holds the transfer function from all the
+  photons run so far.
+
+Notes:
+  The grid is reduced in place in a single call.
+
+History:
+
+**************************************************************/
+
+
+int
+gather_tf_para ()
+{
+#ifdef MPI_ON
+  long n, nbins;
+
+  nbins = (long) reverb_tf_nspec * geo.reverb_tf_nfreq * geo.reverb_tf_ndelay;
+  for (n = 0; n < nbins; n++)
+    reverb_tf[n] /= np_mpi_global;
+
+  MPI_Allreduce (MPI_IN_PLACE, reverb_tf, nbins, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#endif
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                        University of Southampton
+
+Synopsis: gather_wind_paths_para
+
+Arguments:	
+  WindPtr wind
+    the wind, whose path histograms are to be merged
+
+Returns:
+ 
+Description:	
+  Merges the reverberation path histograms of every cell from all
+  the tasks, so that each task holds the histograms made by all of
+  the photons.  The flux is averaged, like the spectra, and the
+  number of photons is summed.
+
+Notes:
+  The histograms only store the bins which have been hit, so only
+  these are sent.  The cells are divided into np_mpi_global blocks,
+  one owned by each task.  Each task first sends the bins of every
+  cell to the task which owns it with MPI_Alltoallv, so each bin
+  is sent once, and the owner merges them.  The merged histograms
+  are then shared with MPI_Allgatherv, since every task draws paths
+  from all of the cells in the spectral cycles.  Merging first means
+  that a bin hit by several tasks is only sent to every task once.
+
+History:
+
+**************************************************************/
+
+
+int
+gather_wind_paths_para (wind)
+     WindPtr wind;
+{
+#ifdef MPI_ON
+  int *ibuf, *iall, *bounds, *scounts, *sdispls, *rcounts, *rdispls;
+  double *dbuf, *dall;
+  int nsend, nrecv, mpi_i;
+
+  bounds = calloc (sizeof (int), np_mpi_global + 1);
+  scounts = calloc (sizeof (int), np_mpi_global);
+  sdispls = calloc (sizeof (int), np_mpi_global);
+  rcounts = calloc (sizeof (int), np_mpi_global);
+  rdispls = calloc (sizeof (int), np_mpi_global);
+
+  /* Task mpi_i owns the cells from bounds[mpi_i] up to bounds[mpi_i+1] */
+  for (mpi_i = 0; mpi_i <= np_mpi_global; mpi_i++)
+    bounds[mpi_i] = (int) ((long) mpi_i * geo.ndim2 / np_mpi_global);
+
+  /* Send the bins of each cell to the task which owns it */
+  nsend = pack_wind_paths_para (wind, 0, geo.ndim2, NULL, NULL);
+  ibuf = calloc (sizeof (int), 3 * nsend + 1);
+  dbuf = calloc (sizeof (double), nsend + 1);
+  nsend = 0;
+  for (mpi_i = 0; mpi_i < np_mpi_global; mpi_i++)
+  {
+    sdispls[mpi_i] = nsend;
+    scounts[mpi_i] = pack_wind_paths_para (wind, bounds[mpi_i], bounds[mpi_i + 1], &ibuf[3 * nsend], &dbuf[nsend]);
+    nsend += scounts[mpi_i];
+  }
+
+  MPI_Alltoall (scounts, 1, MPI_INT, rcounts, 1, MPI_INT, MPI_COMM_WORLD);
+  nrecv = 0;
+  for (mpi_i = 0; mpi_i < np_mpi_global; mpi_i++)
+  {
+    rdispls[mpi_i] = nrecv;
+    nrecv += rcounts[mpi_i];
+  }
+
+  dall = calloc (sizeof (double), nrecv + 1);
+  iall = calloc (sizeof (int), 3 * nrecv + 1);
+  MPI_Alltoallv (dbuf, scounts, sdispls, MPI_DOUBLE, dall, rcounts, rdispls, MPI_DOUBLE, MPI_COMM_WORLD);
+  for (mpi_i = 0; mpi_i < np_mpi_global; mpi_i++)
+  {
+    scounts[mpi_i] *= 3;
+    sdispls[mpi_i] *= 3;
+    rcounts[mpi_i] *= 3;
+    rdispls[mpi_i] *= 3;
+  }
+  MPI_Alltoallv (ibuf, scounts, sdispls, MPI_INT, iall, rcounts, rdispls, MPI_INT, MPI_COMM_WORLD);
+
+  /* Merge them into the histograms of the cells this task owns, averaging the flux */
+  unpack_wind_paths_para (wind, nrecv, iall, dall, 1.0 / np_mpi_global);
+
+  free (ibuf);
+  free (dbuf);
+  free (iall);
+  free (dall);
+
+  /* Share the merged histograms of the cells this task owns with all the others */
+  nsend = pack_wind_paths_para (wind, bounds[rank_global], bounds[rank_global + 1], NULL, NULL);
+  ibuf = calloc (sizeof (int), 3 * nsend + 1);
+  dbuf = calloc (sizeof (double), nsend + 1);
+  pack_wind_paths_para (wind, bounds[rank_global], bounds[rank_global + 1], ibuf, dbuf);
+
+  MPI_Allgather (&nsend, 1, MPI_INT, rcounts, 1, MPI_INT, MPI_COMM_WORLD);
+  nrecv = 0;
+  for (mpi_i = 0; mpi_i < np_mpi_global; mpi_i++)
+  {
+    rdispls[mpi_i] = nrecv;
+    nrecv += rcounts[mpi_i];
+  }
+
+  dall = calloc (sizeof (double), nrecv + 1);
+  iall = calloc (sizeof (int), 3 * nrecv + 1);
+  MPI_Allgatherv (dbuf, nsend, MPI_DOUBLE, dall, rcounts, rdispls, MPI_DOUBLE, MPI_COMM_WORLD);
+  for (mpi_i = 0; mpi_i < np_mpi_global; mpi_i++)
+  {
+    rcounts[mpi_i] *= 3;
+    rdispls[mpi_i] *= 3;
+  }
+  MPI_Allgatherv (ibuf, 3 * nsend, MPI_INT, iall, rcounts, rdispls, MPI_INT, MPI_COMM_WORLD);
+
+  unpack_wind_paths_para (wind, nrecv, iall, dall, 1.0);
+
+  free (ibuf);
+  free (dbuf);
+  free (iall);
+  free (dall);
+  free (bounds);
+  free (scounts);
+  free (sdispls);
+  free (rcounts);
+  free (rdispls);
+#endif
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                        University of Southampton
+
+Synopsis: pack_wind_paths_para
+
+Arguments:	
+  WindPtr wind
+    the wind
+  int nstart, nstop
+    the range of cells to pack
+  int ibuf[]
+    (histogram, bin, number) for each bin, or NULL to count them
+  double dbuf[]
+    the flux in each bin, or NULL to count them
+
+Returns:
+  the number of bins which have been hit in the cells
+ 
+Description:	
+  Copies the bins of the path histograms of cells nstart to 
+  nstop-1 into the buffers for gather_wind_paths_para, and empties
+  the histograms.  The histogram number is n * (geo.reverb_lines + 1)
+  for the general histogram of cell n, plus h + 1 for tracked line h.
+
+Notes:
+
+History:
+
+**************************************************************/
+
+int
+pack_wind_paths_para (wind, nstart, nstop, ibuf, dbuf)
+     WindPtr wind;
+     int nstart, nstop;
+     int ibuf[];
+     double dbuf[];
+{
+  Wind_Paths_Ptr paths;
+  int n, h, k, nhist, nentries;
+
+  nhist = geo.reverb_lines + 1;
+  nentries = 0;
+  for (n = nstart; n < nstop; n++)
+  {
+    for (h = 0; h < nhist; h++)
+    {
+      if ((paths = (h == 0 ? wind[n].paths : wind[n].line_paths[h - 1])) == NULL)
+        continue;
+      if (ibuf == NULL)
+      {
+        nentries += paths->i_nbins;
+        continue;
+      }
+      for (k = 0; k < paths->i_nbins; k++)
+      {
+        ibuf[3 * nentries] = n * nhist + h;
+        ibuf[3 * nentries + 1] = paths->ai_bin[k];
+        ibuf[3 * nentries + 2] = paths->ai_path_num[k];
+        dbuf[nentries] = paths->ad_path_flux[k];
+        nentries++;
+      }
+      paths->i_nbins = 0;       //The bins are now in the buffer, and will come back merged
+    }
+  }
+
+  return (nentries);
+}
+
+
+
+/***********************************************************
+                        University of Southampton
+
+Synopsis: unpack_wind_paths_para
+
+Arguments:	
+  WindPtr wind
+    the wind
+  int nentries
+    the number of bins in the buffers
+  int ibuf[]
+    (histogram, bin, number) for each bin, as from pack_wind_paths_para
+  double dbuf[]
+    the flux in each bin
+  double scale
+    the factor by which to multiply the flux
+
+Returns:
+ 
+Description:	
+  Adds the bins in the buffers to the path histograms
+
+Notes:
+
+History:
+
+**************************************************************/
+
+int
+unpack_wind_paths_para (wind, nentries, ibuf, dbuf, scale)
+     WindPtr wind;
+     int nentries;
+     int ibuf[];
+     double dbuf[];
+     double scale;
+{
+  Wind_Paths_Ptr paths;
+  int n, h, k, nhist;
+
+  nhist = geo.reverb_lines + 1;
+  for (k = 0; k < nentries; k++)
+  {
+    n = ibuf[3 * k] / nhist;
+    h = ibuf[3 * k] % nhist;
+    paths = (h == 0 ? wind[n].paths : line_paths_get (&wind[n], h - 1));
+    wind_paths_add_bin (paths, ibuf[3 * k + 1], scale * dbuf[k], ibuf[3 * k + 2]);
+  }
+
+  return (0);
+}
+
+
+
 /***********************************************************
                         University of Southampton
 
@@ -25,6 +25,20 @@
 ***********************************************************/
 double *reverb_path_bin;
 
+/* The bins are evenly spaced in log(path), so the bin a path falls in can be calculated
+ * directly from the log of the first boundary and the log of the bin width. */
+double reverb_path_bin_lmin, reverb_path_bin_dlog;
+
+/**********************************************************/
+/** @var *int reverb_line_slot
+ * @brief	Which tracked line each line is
+ *
+ * Set in reverb_init() in matom mode. For each line nres,
+ * the index in geo.reverb_line of the line, or -1 if the
+ * line is not being tracked.
+***********************************************************/
+int *reverb_line_slot;
+
 /**********************************************************/
 /** @name 	wind_paths_constructor
  * @brief	Allocates the arrays for a path histogram
@@ -32,8 +46,9 @@ double *reverb_path_bin;
  * @param [in,out] wind		Pointer to parent wind cell
  * @return 					Pointer to onstructed histogram
  *
- * Allocates path bins for a passed wind cell and returns a
- * pointer to the allocated space.
+ * Allocates a path histogram for a passed wind cell and returns
+ * a pointer to the allocated space. Space for the bins is only
+ * allocated as photons are added, by wind_paths_add_bin().
  *
  * @notes
  * 9/3/15	-	Written by SWM
@@ -48,9 +63,8 @@ wind_paths_constructor (WindPtr wind)
     Error ("wind_paths_constructor: Could not allocate memory for cell %d\n", wind->nwind);
     exit (0);
   }
-  paths->ad_path_flux = (double *) calloc (sizeof (double), geo.reverb_path_bins);
-  paths->ai_path_num = (int *) calloc (sizeof (int), geo.reverb_path_bins);
-  if (paths->ad_path_flux == NULL || paths->ai_path_num == NULL)
+  paths->alias = (struct Alias *) calloc (sizeof (alias_dummy), 1);
+  if (paths->alias == NULL)
   {
     Error ("wind_paths_constructor: Could not allocate memory for cell %d bins\n", wind->nwind);
     exit (0);
@@ -77,7 +91,7 @@ int
 reverb_init (WindPtr wind)
 {
   char linelist[LINELENGTH];
-  int i;
+  int i, n;
   double r_rad_min = 0.0, r_rad_max = 0.0, r_rad_min_log, r_rad_max_log, r_delta;
 
   if (geo.reverb == REV_WIND || geo.reverb == REV_MATOM)
@@ -107,12 +121,25 @@ reverb_init (WindPtr wind)
     {                           //Create an even bin spacing in log space
       reverb_path_bin[i] = exp (r_rad_min_log + i * r_delta);
     }
+    reverb_path_bin_lmin = r_rad_min_log;
+    reverb_path_bin_dlog = r_delta;
 
     //Now, initialise the various wind path arrays
     wind_paths_init (wind);
 
     if (geo.reverb == REV_MATOM)
-    {                           //If this is matom mode, detail the line numbers being tracked for use with bindata
+    {                           //If this is matom mode, note which lines are tracked so they can be looked up directly
+      reverb_line_slot = (int *) calloc (sizeof (int), nlines + 1);
+      for (n = 0; n < nlines; n++)
+      {
+        reverb_line_slot[n] = -1;
+        for (i = geo.reverb_lines - 1; i >= 0; i--)
+          if (lin_ptr[n]->where_in_list == geo.reverb_line[i])
+            reverb_line_slot[n] = i;
+      }
+      reverb_line_slot[nlines] = -1;
+
+      //Detail the line numbers being tracked for use with bindata
       sprintf (linelist, "reverb_init: Macro-atom line path tracking is enabled for lines %d", geo.reverb_line[0]);
       for (i = 1; i < geo.reverb_lines; i++)
       {
@@ -142,8 +169,10 @@ reverb_init (WindPtr wind)
  *
  * Iterates over each wind cell, and declares a single 
  * generic 'wind path' array for binning the paths of
- * incident photons in. Also declares a 'wind path' array
- * for each specific line of interest in matom mode.
+ * incident photons in. Also declares the list of 'wind path'
+ * arrays for each specific line of interest in matom mode;
+ * these are only made when a line first records a photon,
+ * see line_paths_get().
  *
  * @notes
  * 10/2/15	-	Written by SWM
@@ -151,20 +180,147 @@ reverb_init (WindPtr wind)
 int
 wind_paths_init (WindPtr wind)
 {
-  int i, j;
+  int i;
 
   for (i = 0; i < geo.ndim2; i++)
   {                             //For each entry in the wind array
     wind[i].paths = (Wind_Paths_Ptr) wind_paths_constructor (&wind[i]);
     wind[i].line_paths = (Wind_Paths_Ptr *) calloc (sizeof (Wind_Paths_Ptr), geo.reverb_lines);
-    for (j = 0; j < geo.reverb_lines; j++)
-    {                           //For each line tracked on each cell
-      wind[i].line_paths[j] = (Wind_Paths_Ptr) wind_paths_constructor (&wind[i]);
+  }
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	line_paths_get
+ * @brief	Returns the path histogram for a tracked line
+ *
+ * @param [in,out] wind		Wind cell
+ * @param [in] i			Index of the line in geo.reverb_line
+ * @return 					Pointer to the histogram
+ *
+ * Makes the histogram the first time it is asked for.
+***********************************************************/
+Wind_Paths_Ptr
+line_paths_get (WindPtr wind, int i)
+{
+  if (wind->line_paths[i] == NULL)
+    wind->line_paths[i] = (Wind_Paths_Ptr) wind_paths_constructor (wind);
+  return (wind->line_paths[i]);
+}
+
+/**********************************************************/
+/** @name 	wind_paths_add_bin
+ * @brief	Adds weight to one bin of a path histogram
+ *
+ * @param [in,out] paths	Path histogram
+ * @param [in] i_bin		Path bin
+ * @param [in] r_flux		Flux to add
+ * @param [in] i_num		Number of photons to add
+ * @return 					0
+ *
+ * Finds the bin in the list of bins that have been hit by
+ * bisection, adding it to the list if it is not there.
+***********************************************************/
+int
+wind_paths_add_bin (Wind_Paths_Ptr paths, int i_bin, double r_flux, int i_num)
+{
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = paths->i_nbins;
+  while (lo < hi)
+  {                             //Find the first entry at or after this bin
+    mid = (lo + hi) / 2;
+    if (paths->ai_bin[mid] < i_bin)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == paths->i_nbins || paths->ai_bin[lo] != i_bin)
+  {                             //This bin has not been hit before, so make space for it
+    if (paths->i_nbins == paths->i_nalloc)
+    {
+      paths->i_nalloc = (paths->i_nalloc > 0 ? 2 * paths->i_nalloc : 8);
+      paths->ai_bin = (int *) realloc (paths->ai_bin, paths->i_nalloc * sizeof (int));
+      paths->ad_path_flux = (double *) realloc (paths->ad_path_flux, paths->i_nalloc * sizeof (double));
+      paths->ai_path_num = (int *) realloc (paths->ai_path_num, paths->i_nalloc * sizeof (int));
+      if (paths->ai_bin == NULL || paths->ad_path_flux == NULL || paths->ai_path_num == NULL)
+      {
+        Error ("wind_paths_add_bin: Could not allocate memory for %d bins\n", paths->i_nalloc);
+        exit (0);
+      }
     }
+    memmove (&paths->ai_bin[lo + 1], &paths->ai_bin[lo], (paths->i_nbins - lo) * sizeof (int));
+    memmove (&paths->ad_path_flux[lo + 1], &paths->ad_path_flux[lo], (paths->i_nbins - lo) * sizeof (double));
+    memmove (&paths->ai_path_num[lo + 1], &paths->ai_path_num[lo], (paths->i_nbins - lo) * sizeof (int));
+    paths->ai_bin[lo] = i_bin;
+    paths->ad_path_flux[lo] = 0.0;
+    paths->ai_path_num[lo] = 0;
+    paths->i_nbins++;
   }
+
+  paths->ad_path_flux[lo] += r_flux;
+  paths->ai_path_num[lo] += i_num;
   return (0);
 }
 
+/**********************************************************/
+/** @name 	wind_paths_flux
+ * @brief	Returns the flux in one bin of a path histogram
+ *
+ * @param [in] paths		Path histogram, which may be NULL
+ * @param [in] i_bin		Path bin
+ * @return 					Flux in the bin
+***********************************************************/
+double
+wind_paths_flux (Wind_Paths_Ptr paths, int i_bin)
+{
+  int i;
+
+  if (paths == NULL)
+    return (0.0);
+  for (i = 0; i < paths->i_nbins; i++)
+    if (paths->ai_bin[i] == i_bin)
+      return (paths->ad_path_flux[i]);
+  return (0.0);
+}
+
+/****************************************************************/
+/** @name		path_bin_index
+ * @brief		Finds the path bin a path lies in
+ *
+ * @param [in]		r_path		Path length
+ * @return 						Bin index, or -1 if outside the bins
+ *
+ * The bins are evenly spaced in log space, so the index is
+ * calculated directly. It is then checked against the bin
+ * boundaries, in case rounding has put it in a neighbour.
+ * A path on a boundary goes in the lower bin.
+ *
+ * @notes
+*****************************************************************/
+int
+path_bin_index (double r_path)
+{
+  int i;
+
+  if (!(r_path >= reverb_path_bin[0] && r_path <= reverb_path_bin[geo.reverb_path_bins]))
+    return (-1);
+
+  i = (log (r_path) - reverb_path_bin_lmin) / reverb_path_bin_dlog;
+  if (i >= geo.reverb_path_bins)
+    i = geo.reverb_path_bins - 1;
+  else if (i < 0)
+    i = 0;
+
+  if (r_path <= reverb_path_bin[i] && i > 0)
+    i--;
+  else if (r_path > reverb_path_bin[i + 1] && i < geo.reverb_path_bins - 1)
+    i++;
+  return (i);
+}
+
 /****************************************************************/
 /** @name		line_paths_add_phot
  * @brief		Following a line emission, increments cell paths
@@ -189,21 +345,12 @@ line_paths_add_phot (WindPtr wind, PhotPtr pp, int *nres)
   if (*nres > nlines || *nres < 0)
     return (0);                 //This is a continuum photon
 
-  for (i = 0; i < geo.reverb_lines; i++)
-  {                             //Iterate over each tracked line
-    if (lin_ptr[*nres]->where_in_list == geo.reverb_line[i])
-    {                           //If the passed line exists within the tracked line array
-      for (j = 0; j < geo.reverb_path_bins; j++)
-      {                         //Iterate over the path bins
-        if (pp->path >= reverb_path_bin[j] && pp->path <= reverb_path_bin[j + 1])
-        {                       //If the photon's path lies in this bin's bounds, record it
-          wind->line_paths[i]->ad_path_flux[j] += pp->w;
-          wind->line_paths[i]->ai_path_num[j]++;
-          break;
-          break;
-        }
-      }
-    }
+  if ((i = reverb_line_slot[*nres]) < 0)
+    return (0);                 //This line is not being tracked
+
+  if ((j = path_bin_index (pp->path)) >= 0)
+  {                             //If the photon's path lies within the bins, record it
+    wind_paths_add_bin (line_paths_get (wind, i), j, pp->w, 1);
   }
   return (0);
 }
@@ -226,14 +373,9 @@ int
 wind_paths_add_phot (WindPtr wind, PhotPtr pp)
 {
   int i;
-  for (i = 0; i < geo.reverb_path_bins; i++)
-  {                             //For each bin
-    if (pp->path >= reverb_path_bin[i] && pp->path <= reverb_path_bin[i + 1])
-    {                           //If the path falls within its bounds, add photon weight
-      wind->paths->ad_path_flux[i] += pp->w;
-      wind->paths->ai_path_num[i]++;
-      break;
-    }
+  if ((i = path_bin_index (pp->path)) >= 0)
+  {                             //If the path falls within the bins, add photon weight
+    wind_paths_add_bin (wind->paths, i, pp->w, 1);
   }
   return (0);
 }
@@ -268,7 +410,9 @@ simple_paths_gen_phot (PhotPtr pp)
  *
  * Picks a random path bin, weighted by the flux in each in
  * this cell, then assigns a path from within that bin 
- * (from a uniform random distribution)
+ * (from a uniform random distribution). The bin is drawn
+ * from the alias table made by wind_paths_evaluate_single(),
+ * so this takes the same time however many bins there are.
  *
  * @notes
  * 26/2/15	-	Written by SWM
@@ -277,22 +421,16 @@ simple_paths_gen_phot (PhotPtr pp)
 double
 r_draw_from_path_histogram (Wind_Paths_Ptr PathPtr)
 {
-  double r_rand, r_total, r_bin_min, r_bin_rand, r_path, r_bin_max;
-  int i_path = -1;
+  double r_bin_min, r_bin_rand, r_path, r_bin_max;
+  int i_path;
 
-  r_total = 0.0;
-  r_rand = PathPtr->d_flux * rand () / MAXRAND;
-  i_path = -1;
-
-  //printf("DEBUG: r_rand %g out of total %g\n",r_rand, PathPtr->d_flux);
-  while (r_rand > r_total)
-  {
-    r_total += PathPtr->ad_path_flux[++i_path];
-  }
+  if (PathPtr->alias->n == 0)
+    return (reverb_path_bin[0]);        //No flux has been recorded, so there is nothing to draw from
+  i_path = PathPtr->ai_bin[alias_get_rand (PathPtr->alias)];
 
   //Assign photon path to a random position within the bin.
-  r_bin_min = reverb_path_bin[i_path - 1];
-  r_bin_max = reverb_path_bin[i_path];
+  r_bin_min = reverb_path_bin[i_path];
+  r_bin_max = reverb_path_bin[i_path + 1];
   r_bin_rand = (rand () / MAXRAND) * (r_bin_max - r_bin_min);
   r_path = r_bin_min + r_bin_rand;
   return (r_path);
@@ -377,29 +515,23 @@ line_paths_gen_phot (WindPtr wind, PhotPtr pp, int nres)
   {                             //If this line is invalid, continuum or non-matom then default to wind
     pp->path = r_draw_from_path_histogram (wind->paths);
   }
-  else
-  {                             //Iterate over array to see if this line is tracked. If so, use that 
-    //array index to find the path array for the line (i.e. the n^th line
-    //being tracked is the n^th line path histogram).
-    for (i = 0; i < geo.reverb_lines; i++)
-    {
-      if (lin_ptr[nres]->where_in_list == geo.reverb_line[i])
-      {                         //Line identified using its position in nres as unique ID
-        if (wind->line_paths[i]->i_num > 0)
-        {                       //If there photons recorded in this histogram
-          pp->path = r_draw_from_path_histogram (wind->line_paths[i]);
-        }
-        else
-        {                       //If there are no photons in this histogram, log and default
-          //to using the wind path histogram.
-          //Error("line_paths_gen_phot: No path data for line %d in cell %d at r=%g, z=%g\n",
-          // wind->nwind, nres, sqrt(wind->x[0]*wind->x[0] + wind->x[1]*wind->x[1]), wind->x[2]);
-          pp->path = r_draw_from_path_histogram (wind->paths);
-        }
-        return (0);
-      }
+  else if ((i = reverb_line_slot[nres]) >= 0)
+  {                             //If this line is tracked, use the path array for the line (i.e. the 
+    //n^th line being tracked is the n^th line path histogram).
+    if (wind->line_paths[i] != NULL && wind->line_paths[i]->i_num > 0)
+    {                           //If there photons recorded in this histogram
+      pp->path = r_draw_from_path_histogram (wind->line_paths[i]);
+    }
+    else
+    {                           //If there are no photons in this histogram, log and default
+      //to using the wind path histogram.
+      //Error("line_paths_gen_phot: No path data for line %d in cell %d at r=%g, z=%g\n",
+      // wind->nwind, nres, sqrt(wind->x[0]*wind->x[0] + wind->x[1]*wind->x[1]), wind->x[2]);
+      pp->path = r_draw_from_path_histogram (wind->paths);
     }
-    //If the line isn't being tracked, default to wind
+  }
+  else
+  {                             //If the line isn't being tracked, default to wind
     pp->path = r_draw_from_path_histogram (wind->paths);
   }
   return (0);
@@ -412,7 +544,8 @@ line_paths_gen_phot (WindPtr wind, PhotPtr pp, int nres)
  * @param [in,out] wind		Wind cell to evaluate
  *
  * Records the total flux in the cell, as well as making a 
- * simple 'average path' calculation.
+ * simple 'average path' calculation, and makes the alias
+ * table used by r_draw_from_path_histogram().
  *
  * @see wind_paths_evaluate()
  *
@@ -423,22 +556,29 @@ line_paths_gen_phot (WindPtr wind, PhotPtr pp, int nres)
 int
 wind_paths_evaluate_single (Wind_Paths_Ptr paths)
 {
-  int i;
+  int i, k;
   paths->d_flux = 0.0;
   paths->d_path = 0.0;
   paths->i_num = 0;
 
-  for (i = 0; i < geo.reverb_path_bins; i++)
-  {                             //For each path bin, add its contribution to total flux & avg path
+  for (i = 0; i < paths->i_nbins; i++)
+  {                             //For each path bin that was hit, add its contribution to total flux & avg path
+    k = paths->ai_bin[i];
     paths->d_flux += paths->ad_path_flux[i];
     paths->i_num += paths->ai_path_num[i];
-    paths->d_path += paths->ad_path_flux[i] * (reverb_path_bin[i] + reverb_path_bin[i + 1]) / 2.0;
+    paths->d_path += paths->ad_path_flux[i] * (reverb_path_bin[k] + reverb_path_bin[k + 1]) / 2.0;
   }
 
   //If there was any data in this cell, calculate avg. path
   if (paths->i_num > 0)
     paths->d_path /= paths->d_flux;
 
+  //Make the table that paths are drawn from in the spectral cycles
+  if (paths->d_flux > 0.0)
+    alias_gen (paths->alias, paths->ad_path_flux, paths->i_nbins);
+  else
+    paths->alias->n = 0;
+
   return (0);
 }
 
@@ -468,7 +608,8 @@ wind_paths_evaluate (WindPtr wind)
       wind_paths_evaluate_single (wind[i].paths);
       for (j = 0; j < geo.reverb_lines; j++)
       {
-        wind_paths_evaluate_single (wind[i].line_paths[j]);
+        if (wind[i].line_paths[j] != NULL)
+          wind_paths_evaluate_single (wind[i].line_paths[j]);
       }
     }
   }
@@ -535,11 +676,11 @@ wind_paths_dump (WindPtr wind)
 
   for (k = 0; k < geo.reverb_path_bins; k++)
   {                             //For each path bin, print the 'wind' weight 
-    fprintf (fptr, "%g, %g", reverb_path_bin[k], wind->paths->ad_path_flux[k]);
+    fprintf (fptr, "%g, %g", reverb_path_bin[k], wind_paths_flux (wind->paths, k));
 
     for (j = 0; j < geo.reverb_lines; j++)
     {                           //For each tracked line, print the weight in this bin
-      fprintf (fptr, ", %g", wind->line_paths[j]->ad_path_flux[k]);
+      fprintf (fptr, ", %g", wind_paths_flux (wind->line_paths[j], k));
     }
     fprintf (fptr, "\n");
   }
@@ -49,6 +49,15 @@
 		pdf_to_file(&pdf,filename)				
  		  	to write a pdf structure to a file
 
+	For discrete distributions, e.g. choosing the cell from which a photon is emitted,
+	there are two further routines
+
+		alias_gen(&alias,weight,n)
+			Generate an alias table for n outcomes with weights weight[]
+
+		alias_get_rand(&alias)
+			Return one of the outcomes.  The time this takes does not depend on n.
+
 
 								
 Arguments for pdf_gen_from_func
@@ -244,6 +253,7 @@ pdf_gen_from_func (pdf, func, xmin, xmax, njumps, jump)
   double gen_array_from_func (), delta;
 
   njump_min = njump_max = 0;
+  perf_count[PERF_PDF_GEN]++;
   /* Check the input data before proceeding */
   if (xmax <= xmin)
   {
@@ -541,6 +551,7 @@ pdf_gen_from_array (pdf, x, y, n_xy, xmin, xmax, njumps, jump)
   double ysum;
   int echeck, pdf_check (), recalc_pdf_from_cdf ();
 
+  perf_count[PERF_PDF_GEN]++;
 
   /* Check the inputs */
   if (xmax < xmin)
@@ -1159,3 +1170,130 @@ recalc_pdf_from_cdf (pdf)
 
   return (0);
 }
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	alias_gen makes an alias table from which outcomes 0 to n-1 can be drawn with
+	probabilities proportional to weight[]
+
+ Arguments:
+	AliasPtr alias		The table, whose arrays are allocated (or enlarged) here
+	double weight[]		The weights of the outcomes.  They must not be negative
+	int n			The number of outcomes
+
+ Returns:
+	0 on success, -1 if n is less than 1 or the weights sum to zero, in which case
+	the table should not be used
+ 
+Description:
+	This is Vose's version of Walker's alias method.  Each of the n columns of the
+	table holds the outcome i with probability prob[i], and otherwise alias[i].  The 
+	columns are filled by pairing outcomes whose weight is less than the average with 
+	outcomes whose weight is greater than it.
+
+	Outcomes with zero weight are never returned.
+
+Notes:
+	The arrays are reused if alias has already been used for a table at least as large,
+	so the structure should be zeroed (as globals are) before it is first used.
+
+**************************************************************/
+
+int
+alias_gen (alias, weight, n)
+     AliasPtr alias;
+     double weight[];
+     int n;
+{
+  int i, nsmall, nlarge, s, l;
+  int *small, *large;
+  double *q;
+
+  alias->n = 0;
+  alias->total = 0;
+  if (n < 1)
+    return (-1);
+
+  for (i = 0; i < n; i++)
+    alias->total += weight[i];
+  if (alias->total <= 0)
+    return (-1);
+
+  if (n > alias->nalloc)
+  {
+    alias->prob = realloc (alias->prob, n * sizeof (double));
+    alias->alias = realloc (alias->alias, n * sizeof (int));
+    if (alias->prob == NULL || alias->alias == NULL)
+    {
+      Error ("alias_gen: Could not allocate space for %d outcomes\n", n);
+      exit (0);
+    }
+    alias->nalloc = n;
+  }
+  alias->n = n;
+
+  q = alias->prob;
+  small = calloc (n, sizeof (int));
+  large = calloc (n, sizeof (int));
+
+  nsmall = nlarge = 0;
+  for (i = 0; i < n; i++)
+  {
+    q[i] = weight[i] * n / alias->total;
+    alias->alias[i] = i;
+    if (q[i] < 1.0)
+      small[nsmall++] = i;
+    else
+      large[nlarge++] = i;
+  }
+
+  while (nsmall > 0 && nlarge > 0)
+  {
+    s = small[--nsmall];
+    l = large[nlarge - 1];
+    alias->alias[s] = l;
+    q[l] -= (1.0 - q[s]);
+    if (q[l] < 1.0)
+    {
+      nlarge--;
+      small[nsmall++] = l;
+    }
+  }
+
+  /* Whatever is left over is only not 1 because of roundoff */
+  while (nlarge > 0)
+    q[large[--nlarge]] = 1.0;
+  while (nsmall > 0)
+  {
+    s = small[--nsmall];
+    q[s] = (weight[s] > 0) ? 1.0 : 0.0;
+  }
+
+  free (small);
+  free (large);
+
+  return (0);
+}
+
+
+
+/* alias_get_rand returns an outcome from a table made by alias_gen */
+
+int
+alias_get_rand (alias)
+     AliasPtr alias;
+{
+  int i;
+
+  i = (rand () / MAXRAND) * alias->n;
+  if (i >= alias->n)
+    i = alias->n - 1;
+
+  if (rand () / MAXRAND < alias->prob[i])
+    return (i);
+  return (alias->alias[i]);
+}
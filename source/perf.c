@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "atomic.h"
+#include "python.h"
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	perf_init prepares the timers and counters which record where
+	the time goes in each cycle, and starts the file root.perf to
+	which they are written by perf_report
+
+ Arguments:		
+
+	restart_stat	1 if this is a restart, in which case the
+			timings are appended to an existing file
+
+ Returns:
+
+	0
+ 
+ Description:
+
+ Notes:
+
+	The timers and counters are the arrays perf_time and perf_count, indexed
+	by the PERF_ definitions in perf.h.  They are zeroed by perf_reset at
+	the start of each cycle.  Timers are accumulated with 
+	perf_start and perf_stop, which may be called many times in a cycle;
+	counters are simply incremented where the event happens, e.g.
+	perf_count[PERF_SCATTERS]++.  
+
+	The file has one line for each timer and counter in each cycle, giving
+	the minimum, mean and maximum over the MPI processes.
+
+**************************************************************/
+
+double perf_cycle_start = 0.0;
+char *perf_timer_names[NPERF_TIMERS] = { "photon_gen", "transport", "extract", "communicate", "wind_update", "ionization", "windsave" };
+char *perf_count_names[NPERF_COUNTERS] = { "cell_crossings", "resonances", "scatters", "matom_jumps", "pdf_gen", "qromb" };
+
+int
+perf_init (restart_stat)
+     int restart_stat;
+{
+  FILE *fptr;
+
+  fptr = NULL;
+  perf_reset ();
+
+  if (rank_global == 0 && (restart_stat == 0 || (fptr = fopen (files.perf, "r")) == NULL))
+  {
+    if ((fptr = fopen (files.perf, "w")) == NULL)
+    {
+      Error ("perf_init: Unable to open %s\n", files.perf);
+      return (0);
+    }
+    fprintf (fptr, "# Timings (s) and counts for each cycle: the minimum, mean and maximum over %d processes\n", np_mpi_global);
+    fprintf (fptr, "# The total is the time for the whole cycle; transport includes extract, and wind_update includes ionization\n");
+    fprintf (fptr, "# extract is estimated from the extractions of one photon in every %d\n", PERF_EXTRACT_BATCH);
+    fprintf (fptr, "Cycle_type Cycle Kind Name Min Mean Max\n");
+  }
+  if (fptr != NULL)
+    fclose (fptr);
+
+  return (0);
+}
+
+
+
+/* Zero the timers and counters at the start of a cycle */
+
+int
+perf_reset ()
+{
+  int n;
+
+  for (n = 0; n < NPERF_TIMERS; n++)
+    perf_time[n] = perf_time_start[n] = 0.0;
+  for (n = 0; n < NPERF_COUNTERS; n++)
+    perf_count[n] = 0;
+  perf_cycle_start = timer ();
+
+  return (0);
+}
+
+
+
+/* Start and stop one of the timers.  The time between the two is added to the total for the cycle */
+
+int
+perf_start (itimer)
+     int itimer;
+{
+  perf_time_start[itimer] = timer ();
+  return (0);
+}
+
+
+int
+perf_stop (itimer)
+     int itimer;
+{
+  perf_time[itimer] += timer () - perf_time_start[itimer];
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	perf_report writes out the timers and counters for a cycle
+
+ Arguments:		
+
+	cycle_type	"ionization" or "spectrum"
+	cycle		the number of the cycle
+
+ Returns:
+
+	0
+ 
+ Description:
+
+	Each process logs its own timings.  The minimum, mean and maximum over 
+	the processes are then gathered to the master process, which appends
+	them to root.perf.
+
+ Notes:
+
+	With MPI this must be called by all processes, since it involves
+	reductions.
+
+**************************************************************/
+
+int
+perf_report (cycle_type, cycle)
+     char *cycle_type;
+     int cycle;
+{
+  double value[NPERF_TIMERS + NPERF_COUNTERS + 1];
+  double vmin[NPERF_TIMERS + NPERF_COUNTERS + 1], vmax[NPERF_TIMERS + NPERF_COUNTERS + 1], vsum[NPERF_TIMERS + NPERF_COUNTERS + 1];
+  int n, nvalues, np;
+  FILE *fptr;
+
+  /* The first value is the time for the whole cycle, followed by the timers and the counters */
+
+  nvalues = NPERF_TIMERS + NPERF_COUNTERS + 1;
+  value[0] = timer () - perf_cycle_start;
+  for (n = 0; n < NPERF_TIMERS; n++)
+    value[n + 1] = perf_time[n];
+  for (n = 0; n < NPERF_COUNTERS; n++)
+    value[n + NPERF_TIMERS + 1] = perf_count[n];
+
+  Log_silent
+    ("perf_report: %s cycle %d took %.2f s: photon_gen %.2f transport %.2f (extract %.2f) communicate %.2f wind_update %.2f (ionization %.2f) windsave %.2f\n",
+     cycle_type, cycle, value[0], value[PERF_PHOTON_GEN + 1], value[PERF_TRANSPORT + 1], value[PERF_EXTRACT + 1],
+     value[PERF_COMMUNICATE + 1], value[PERF_WIND_UPDATE + 1], value[PERF_IONIZATION + 1], value[PERF_WINDSAVE + 1]);
+
+#ifdef MPI_ON
+  MPI_Reduce (value, vmin, nvalues, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+  MPI_Reduce (value, vmax, nvalues, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce (value, vsum, nvalues, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  np = np_mpi_global;
+#else
+  for (n = 0; n < nvalues; n++)
+    vmin[n] = vmax[n] = vsum[n] = value[n];
+  np = 1;
+#endif
+
+  if (rank_global == 0)
+  {
+    if ((fptr = fopen (files.perf, "a")) == NULL)
+    {
+      Error ("perf_report: Unable to open %s\n", files.perf);
+    }
+    else
+    {
+      fprintf (fptr, "%-10s %3d timer   %-14s %12.4f %12.4f %12.4f\n", cycle_type, cycle, "total", vmin[0], vsum[0] / np, vmax[0]);
+      for (n = 0; n < NPERF_TIMERS; n++)
+        fprintf (fptr, "%-10s %3d timer   %-14s %12.4f %12.4f %12.4f\n", cycle_type, cycle, perf_timer_names[n], vmin[n + 1],
+                 vsum[n + 1] / np, vmax[n + 1]);
+      for (n = 0; n < NPERF_COUNTERS; n++)
+        fprintf (fptr, "%-10s %3d counter %-14s %12.0f %12.1f %12.0f\n", cycle_type, cycle, perf_count_names[n],
+                 vmin[n + NPERF_TIMERS + 1], vsum[n + NPERF_TIMERS + 1] / np, vmax[n + NPERF_TIMERS + 1]);
+      fclose (fptr);
+    }
+  }
+
+  return (0);
+}
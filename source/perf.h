@@ -0,0 +1,24 @@
+/* Timers and counters which record where the time goes in each cycle.  The timers are accumulated on
+   each process with perf_start and perf_stop, the counters are incremented directly, and both are 
+   written out at the end of each cycle by perf_report, see perf.c.  They are kept out of python.h
+   so that routines such as qromb, which are also used without python.h, can increment the counters */
+#define PERF_PHOTON_GEN   0     // define_phot
+#define PERF_TRANSPORT    1     // trans_phot, including extraction
+#define PERF_EXTRACT      2     // extract, estimated from one photon in each batch of PERF_EXTRACT_BATCH, see trans_phot
+#define PERF_COMMUNICATE  3     // MPI communication of the estimators and spectra
+#define PERF_WIND_UPDATE  4     // wind_update, including the ionization calculation
+#define PERF_IONIZATION   5     // ion_abundances, summed over cells
+#define PERF_WINDSAVE     6     // wind_save
+#define NPERF_TIMERS      7
+#define PERF_EXTRACT_BATCH 100
+
+#define PERF_CROSSINGS    0     // calls to translate_in_wind, that is steps through a cell
+#define PERF_RESONANCES   1     // lines found to be in resonance by calculate_ds
+#define PERF_SCATTERS     2     // scatters in trans_phot
+#define PERF_MATOM_JUMPS  3     // jumps made in matom
+#define PERF_PDF_GEN      4     // pdfs generated from functions or arrays
+#define PERF_QROMB        5     // calls to qromb
+#define NPERF_COUNTERS    6
+
+double perf_time[NPERF_TIMERS], perf_time_start[NPERF_TIMERS];
+long perf_count[NPERF_COUNTERS];
@@ -337,26 +337,28 @@ ds_to_cone (cc, p)
   double dz, dzdr2;
   double a, b, c, root[2];
   double s_to_zero;             /* The path length to the xy plane */
+  double z, lz;
   int i;
-  struct photon pp;
 
-  /* First of all let's work only in the "northern" hemisphere */
-  stuff_phot (p, &pp);
+  /* First of all let's work only in the "northern" hemisphere.  Only the z components
+     of the position and direction are affected, so there is no need to copy the photon */
 
-  if (pp.x[2] < 0.0)
+  z = p->x[2];
+  lz = p->lmn[2];
+  if (z < 0.0)
   {                             /*move the photon to the northen hemisphere */
-    pp.x[2] = -pp.x[2];
-    pp.lmn[2] = -pp.lmn[2];
+    z = -z;
+    lz = -lz;
   }
 
   /* Set up and solve the quadratic equation that gives the cone intercept */
 
   dzdr2 = cc->dzdr * cc->dzdr;
-  dz = pp.x[2] - cc->z;
+  dz = z - cc->z;
 
-  a = dzdr2 * (pp.lmn[0] * pp.lmn[0] + pp.lmn[1] * pp.lmn[1]) - (pp.lmn[2] * pp.lmn[2]);
-  b = 2. * (dzdr2 * (pp.lmn[0] * pp.x[0] + pp.lmn[1] * pp.x[1]) - pp.lmn[2] * dz);
-  c = dzdr2 * (pp.x[0] * pp.x[0] + pp.x[1] * pp.x[1]) - dz * dz;
+  a = dzdr2 * (p->lmn[0] * p->lmn[0] + p->lmn[1] * p->lmn[1]) - (lz * lz);
+  b = 2. * (dzdr2 * (p->lmn[0] * p->x[0] + p->lmn[1] * p->x[1]) - lz * dz);
+  c = dzdr2 * (p->x[0] * p->x[0] + p->x[1] * p->x[1]) - dz * dz;
 
   i = quadratic (a, b, c, root);        /* root[i] is the smallest positive root unless i is
                                            negative in which case either both roots were negative or both roots were imaginary */
@@ -365,10 +367,10 @@ ds_to_cone (cc, p)
      photon is travelling in the xy plane or if the intercept is in the negative
      direction set the path length to infinity */
 
-  if (pp.x[2] * pp.lmn[2] >= 0)
+  if (z * lz >= 0)
     s_to_zero = VERY_BIG;
   else
-    s_to_zero = (-pp.x[2] / pp.lmn[2]);
+    s_to_zero = (-z / lz);
 
 
   if (i >= 0 && root[i] < s_to_zero)
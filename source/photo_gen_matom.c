@@ -483,6 +483,77 @@ get_matom_f (mode)
 
 
 
+/************************************************************
+                                    
+Synopsis:
+
+     matom_alias_init makes the alias tables used by photo_gen_kpkt and photo_gen_matom
+     to choose the cell, and the macro atom level, from which each photon is emitted
+
+Arguments:   
+
+Returns:   
+     0 
+
+Description:
+     alias_kpkt and alias_matom are indexed by the element of wmain, so that cells
+     without volume are given zero weight.  The weight of a cell in alias_matom is the
+     sum of the emissivities of all of its macro atom levels, and alias_matom_level[nplasma]
+     then chooses the level.  Choosing a cell and a level then takes a time which does
+     not depend on the number of cells or levels.
+
+Notes:  
+     This must be called after get_matom_f and get_kpkt_f, since the tables are 
+     built from matom_emiss and kpkt_emiss.
+
+************************************************************/
+
+int
+matom_alias_init ()
+{
+  int n, nplasma;
+  double *weight;
+
+  weight = calloc (NDIM2, sizeof (double));
+
+  for (n = 0; n < NDIM2; n++)
+  {
+    weight[n] = 0;
+    if (wmain[n].vol > 0.0)
+      weight[n] = plasmamain[wmain[n].nplasma].kpkt_emiss;
+  }
+  alias_gen (&alias_kpkt, weight, NDIM2);
+
+  if (alias_matom_nplasma < NPLASMA)
+  {
+    alias_matom_level = realloc (alias_matom_level, NPLASMA * sizeof (alias_dummy));
+    for (n = alias_matom_nplasma; n < NPLASMA; n++)
+    {
+      alias_matom_level[n].n = alias_matom_level[n].nalloc = 0;
+      alias_matom_level[n].prob = NULL;
+      alias_matom_level[n].alias = NULL;
+    }
+    alias_matom_nplasma = NPLASMA;
+  }
+
+  for (nplasma = 0; nplasma < NPLASMA; nplasma++)
+    alias_gen (&alias_matom_level[nplasma], macromain[nplasma].matom_emiss, nlevels_macro);
+
+  for (n = 0; n < NDIM2; n++)
+  {
+    weight[n] = 0;
+    if (wmain[n].vol > 0.0)
+      weight[n] = alias_matom_level[wmain[n].nplasma].total;
+  }
+  alias_gen (&alias_matom, weight, NDIM2);
+
+  free (weight);
+
+  return (0);
+}
+
+
+
 /************************************************************
                                     Imperial College London
 Synopsis:
@@ -532,7 +603,6 @@ photo_gen_kpkt (p, weight, photstart, nphot)
 {
   int photstop;
   int icell;
-  double xlum, xlumsum;
   struct photon pp;
   int nres, esc_ptr;
   int n;
@@ -541,7 +611,6 @@ photo_gen_kpkt (p, weight, photstart, nphot)
   double test;
   int nnscat;
   double dvwind_ds (), sobolev ();
-  int nplasma;
   int ndom;
 
 
@@ -553,20 +622,7 @@ photo_gen_kpkt (p, weight, photstart, nphot)
   {
     /* locate the wind_cell in which the photon bundle originates. */
 
-    xlum = (rand () + 0.5) / (MAXRAND) * geo.f_kpkt;
-
-    xlumsum = 0;
-    icell = 0;
-    while (xlumsum < xlum)
-    {
-      if (wmain[icell].vol > 0.0)
-      {
-        nplasma = wmain[icell].nplasma;
-        xlumsum += plasmamain[nplasma].kpkt_emiss;
-      }
-      icell++;
-    }
-    icell--;                    /* This is the cell in which the photon must be generated */
+    icell = alias_get_rand (&alias_kpkt);       /* This is the cell in which the photon must be generated */
 
     /* Now generate a single photon in this cell */
     p[n].w = weight;
@@ -718,7 +774,6 @@ photo_gen_matom (p, weight, photstart, nphot)
 {
   int photstop;
   int icell;
-  double xlum, xlumsum;
   struct photon pp;
   int nres;
   int n;
@@ -742,41 +797,9 @@ photo_gen_matom (p, weight, photstart, nphot)
     /* locate the wind_cell in which the photon bundle originates. And also decide which of the macro
        atom levels will be sampled (identify that level as "upper"). */
 
-    xlum = (rand () + 0.5) / (MAXRAND) * geo.f_matom;
-
-    xlumsum = 0;
-    icell = 0;
-    upper = 0;
-    while (xlumsum < xlum)
-    {
-      if (wmain[icell].vol > 0.0)
-      {
-        nplasma = wmain[icell].nplasma;
-        xlumsum += macromain[nplasma].matom_emiss[upper];
-        upper++;
-        if (upper == nlevels_macro)
-        {
-          upper = 0;
-          icell++;
-        }
-      }
-      else
-      {
-        icell++;
-        upper = 0;
-      }
-    }
-
-    if (upper == 0)
-    {
-      /* If upper = 0 at this point it means the loop above finished with an increment of
-         icell and setting upper = 0. In such a case the process we want was the LAST process
-         in the previous cell. */
-      icell--;
-      upper = nlevels_macro;
-    }
-
-    upper--;                    /* This leaves the macro atom level that deactivaties. */
+    icell = alias_get_rand (&alias_matom);
+    nplasma = wmain[icell].nplasma;
+    upper = alias_get_rand (&alias_matom_level[nplasma]);       /* This is the macro atom level that deactivates. */
 
     /* Now generate a single photon in this cell */
     p[n].w = weight;
@@ -133,6 +133,20 @@ photon hit the star in its passage from pold to the current position */
   return (pp->istat);
 }
 
+/* The spheres which bound the wind, as squares of their radii, and the square of the outer radius
+   of each domain.  They are set up by ds_to_wind_init */
+
+struct wind_bounds
+{
+  int nsphere;
+  double r2[2 * MaxDom + 1];
+  double rmax2[MaxDom];
+  int ndomain;
+  double rmax;
+} wbound;
+
+
+
 /***********************************************************
                                        Space Telescope Science Institute
 
@@ -223,43 +237,51 @@ double
 ds_to_wind (pp)
      PhotPtr pp;
 {
-  struct photon ptest;
-  double ds, x;
-  int ndom;
+  double ds, x, b, xx;
+  int n, ndom;
 
-  stuff_phot (pp, &ptest);
+  if (!wind_bounds_ok || wbound.ndomain != geo.ndomain || wbound.rmax != geo.rmax)
+    ds_to_wind_init ();
 
-  /* First calculated the distance to the edge of the of
-     all of the "computatational domain */
+  /* These are all that is needed to find where the ray intercepts a sphere centered on the origin */
+  b = dot (pp->x, pp->lmn);
+  xx = dot (pp->x, pp->x);
 
-  ds = ds_to_sphere (geo.rmax, &ptest);
+  /* First calculate the distance to the edge of the "computational domain" and to the inner 
+     and outer radii of all of the domains */
 
-  for (ndom = 0; ndom < geo.ndomain; ndom++)
+  ds = VERY_BIG;
+  for (n = 0; n < wbound.nsphere; n++)
   {
-    /* Check if the photon hits the inner or outer radius of the wind */
-    if ((x = ds_to_sphere (zdom[ndom].rmax, &ptest)) < ds)
+    if ((x = ds_to_sphere_sq (wbound.r2[n], b, xx)) < ds)
       ds = x;
+  }
 
-    if ((x = ds_to_sphere (zdom[ndom].rmin, &ptest)) < ds)
-      ds = x;
+  for (ndom = 0; ndom < geo.ndomain; ndom++)
+  {
+    /* If the photon is outside the domain and the ray misses its outer radius, the photon 
+       cannot enter the domain, and there is no need to look at its other boundaries */
+
+    if (xx > wbound.rmax2[ndom] && (b >= 0 || b * b < xx - wbound.rmax2[ndom]))
+      continue;
 
     /* Check if the photon hits the inner or outer windcone */
 
-    if ((x = ds_to_cone (&zdom[ndom].windcone[0], &ptest)) < ds)
+    if ((x = ds_to_cone (&zdom[ndom].windcone[0], pp)) < ds)
       ds = x;
-    if ((x = ds_to_cone (&zdom[ndom].windcone[1], &ptest)) < ds)
+    if ((x = ds_to_cone (&zdom[ndom].windcone[1], pp)) < ds)
       ds = x;
 
     if (zdom[ndom].wind_type == CORONA)
     {
 
       /* As currently written ds_to_plane can give a negative number */
-      x = ds_to_plane (&zdom[ndom].windplane[0], &ptest);
+      x = ds_to_plane (&zdom[ndom].windplane[0], pp);
       if (x > 0 && x < ds)
       {
         ds = x;
       }
-      x = ds_to_plane (&zdom[ndom].windplane[1], &ptest);
+      x = ds_to_plane (&zdom[ndom].windplane[1], pp);
       if (x > 0 && x < ds)
       {
         ds = x;
@@ -270,7 +292,7 @@ ds_to_wind (pp)
     /* Check if the photon hits the pillpox portion of an Elvis wind */
     if (zdom[ndom].wind_type == ELVIS)
     {
-      x = ds_to_pillbox (&ptest, zdom[ndom].sv_rmin, zdom[ndom].sv_rmax, zdom[ndom].elvis_offset);
+      x = ds_to_pillbox (pp, zdom[ndom].sv_rmin, zdom[ndom].sv_rmax, zdom[ndom].elvis_offset);
       if (x < ds)
         ds = x;
     }
@@ -281,6 +303,110 @@ ds_to_wind (pp)
 
 
 
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:   
+	ds_to_wind_init collects the spheres which bound the wind in all of the 
+	domains, so that ds_to_wind does not have to assemble them for each photon
+  
+ Arguments:		
+	
+ Returns:
+	The number of distinct spheres
+  
+Description:	
+	The spheres are geo.rmax and the inner and outer radii of each domain.  
+	Spheres which appear more than once, e.g. when several domains have the 
+	same outer radius, are only included once.  The squares of the radii are 
+	stored since that is what ds_to_sphere_sq needs.
+
+Notes:
+	ds_to_wind calls this routine itself when wind_bounds_ok is FALSE or 
+	when the number of domains or geo.rmax has changed.  wind_bounds_ok 
+	is set to FALSE in define_wind and wind_read, where the domains are
+	set up.
+
+**************************************************************/
+
+int
+ds_to_wind_init ()
+{
+  int n, ndom, k;
+  double r[2 * MaxDom + 1];
+
+  r[0] = geo.rmax;
+  n = 1;
+  for (ndom = 0; ndom < geo.ndomain; ndom++)
+  {
+    r[n++] = zdom[ndom].rmax;
+    r[n++] = zdom[ndom].rmin;
+    wbound.rmax2[ndom] = zdom[ndom].rmax * zdom[ndom].rmax;
+  }
+
+  wbound.nsphere = 0;
+  for (k = 0; k < n; k++)
+  {
+    for (ndom = 0; ndom < wbound.nsphere; ndom++)
+      if (wbound.r2[ndom] == r[k] * r[k])
+        break;
+    if (ndom == wbound.nsphere)
+      wbound.r2[wbound.nsphere++] = r[k] * r[k];
+  }
+
+  wbound.ndomain = geo.ndomain;
+  wbound.rmax = geo.rmax;
+  wind_bounds_ok = TRUE;
+
+  return (wbound.nsphere);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:   
+	ds_to_sphere_sq is a version of ds_to_sphere for use when the same ray 
+	is to be tested against a number of spheres centered on the origin
+  
+ Arguments:		
+	double r2		The square of the radius of the sphere
+	double b		The dot product of the position and direction of the photon
+	double xx		The square of the distance of the photon from the origin
+	
+ Returns:
+	The distance to the sphere, or VERY_BIG if the photon does not hit it
+  
+Description:	
+	The result is the same as that of ds_to_sphere.  Rays which start 
+	outside the sphere and either move away from it or miss it are
+	rejected before the quadratic is solved.
+
+Notes:
+
+**************************************************************/
+
+double
+ds_to_sphere_sq (r2, b, xx)
+     double r2, b, xx;
+{
+  double root[2];
+  int i;
+
+  if (xx > r2 && (b >= 0 || b * b < xx - r2))
+    return (VERY_BIG);
+
+  i = quadratic (1., 2. * b, xx - r2, root);
+
+  if (i >= 0)
+    return (root[i]);
+
+  return (VERY_BIG);
+}
+
+
+
 /***********************************************************
                                        Space Telescope Science Institute
 
@@ -366,6 +492,8 @@ return and record an error */
     return (n);                 /* Photon was not in grid */
   }
 
+  perf_count[PERF_CROSSINGS]++;
+
 /* Assign the pointers for the cell containing the photon */
 
   one = &wmain[n];              /* one is the grid cell where the photon is */
@@ -175,6 +175,8 @@ Description:
 
 		
 Notes:
+	If geo.adaptive_bands is set, the number of photons in each band during the
+	ionization cycles is partly determined by band->adapt_fraction. See bands_adapt.
 
 History:
 	04dec	ksl	54a -- small mod to eliminate -O3 warning.
@@ -190,7 +192,7 @@ populate_bands (f1, f2, ioniz_or_final, iwind, band)
      struct xbands *band;
 
 {
-  double ftot, frac_used, z;
+  double ftot, frac_used, z, adapt_tot;
   int n, nphot, most;
   int xdefine_phot ();
 
@@ -223,9 +225,36 @@ populate_bands (f1, f2, ioniz_or_final, iwind, band)
   most = 0;
 
 
+  /* If adaptive sampling is on, and we are in the ionization cycles, part of the photons are
+     distributed according to band->adapt_fraction, which was set up by bands_adapt at the end
+     of the last cycle. Only bands which can actually produce photons are included. Since
+     (1 - geo.adaptive_fraction) of the standard distribution is always retained, every band
+     with flux still gets photons, and the weights set in define_phot from nat_fraction and
+     used_fraction keep the total luminosity in each band correct */
+
+  adapt_tot = 0;
+  if (geo.adaptive_bands && ioniz_or_final == 0)
+  {
+    for (n = 0; n < band->nbands; n++)
+    {
+      if (band->flux[n] > 0)
+        adapt_tot += band->adapt_fraction[n];
+    }
+  }
+
   for (n = 0; n < band->nbands; n++)
   {
     band->used_fraction[n] = band->min_fraction[n] + (1 - frac_used) * band->nat_fraction[n];
+    if (adapt_tot > 0)
+    {
+      z = (band->flux[n] > 0) ? band->adapt_fraction[n] / adapt_tot : 0.0;
+      band->used_fraction[n] = (1. - geo.adaptive_fraction) * band->used_fraction[n] + geo.adaptive_fraction * z;
+    }
+  }
+
+  z = 0;
+  for (n = 0; n < band->nbands; n++)
+  {
     nphot += band->nphot[n] = NPHOT * band->used_fraction[n];
     if (band->used_fraction[n] > z)
     {
@@ -357,6 +386,8 @@ iwind = -1 	Don't generate any wind photons at all
     geo.f_kpkt = get_kpkt_f (); /* This returns the specific luminosity 
                                    in the spectral band of interest */
 
+    matom_alias_init ();        /* Make the tables used to choose where k-packets and macro atoms emit */
+
     matom_emiss_report ();      // function which logs the macro atom level emissivites  
   }
 
@@ -726,6 +757,7 @@ photo_gen_star (p, r, t, weight, f1, f2, spectype, istart, nphot)
      int istart, nphot;         /* Respecitively the starting point in p and the number of photons to generate */
 {
   double freqmin, freqmax, dfreq;
+  double zstar;
   int i, iend;
   if ((iend = istart + nphot) > NPHOT)
   {
@@ -741,6 +773,7 @@ photo_gen_star (p, r, t, weight, f1, f2, spectype, istart, nphot)
   freqmax = f2;
   dfreq = (freqmax - freqmin) / MAXRAND;
   r = (1. + EPSILON) * r;       /* Generate photons just outside the photosphere */
+  zstar = zdisk (r);            /* Photons must not be generated closer to the disk plane than this */
   for (i = istart; i < iend; i++)
   {
     p[i].origin = PTYPE_STAR;   // For BL photons this is corrected in photon_gen 
@@ -774,15 +807,15 @@ photo_gen_star (p, r, t, weight, f1, f2, spectype, istart, nphot)
 
     if (geo.disk_type == DISK_VERTICALLY_EXTENDED)
     {
-      while (fabs (p[i].x[2]) < zdisk (r))
+      while (fabs (p[i].x[2]) < zstar)
       {
         randvec (p[i].x, r);
       }
 
 
-      if (fabs (p[i].x[2]) < zdisk (r))
+      if (fabs (p[i].x[2]) < zstar)
       {
-        Error ("Photon_gen: stellar photon %d in disk %g %g %g %g %g\n", i, p[i].x[0], p[i].x[1], p[i].x[2], zdisk (r), r);
+        Error ("Photon_gen: stellar photon %d in disk %g %g %g %g %g\n", i, p[i].x[0], p[i].x[1], p[i].x[2], zstar, r);
         exit (0);
       }
     }
@@ -872,6 +905,8 @@ disk_init (rmin, rmax, m, mdot, freqmin, freqmax, ioniz_or_final, ftot)
   int spectype;
   double emit, emittance_bb (), emittance_continuum ();
 
+  disk_pdf_ok = FALSE;          // The annulae are about to change
+
   /* Calculate the reference temperature and luminosity of the disk */
   tref = tdisk (m, mdot, rmin);
   gref = gdisk (m, mdot, rmin);
@@ -1008,6 +1043,10 @@ disk_init (rmin, rmax, m, mdot, freqmin, freqmax, ioniz_or_final, ftot)
     disk.t_hit[nrings] = 0;
   }
 
+  /* Make the distributions from which photo_gen_disk will draw the photons of each annulus */
+  if (spectype > -1)
+    disk_pdf_init (spectype, freqmin, freqmax);
+
   geo.lum_disk = ltot;
   return (ltot);
 }
@@ -1141,7 +1180,7 @@ photo_gen_disk (p, weight, f1, f2, spectype, istart, nphot)
       else
       {
         z = zdisk (r);
-        theta = asin ((zdisk (r * (1. + EPSILON)) - z) / (EPSILON * r));
+        theta = asin (zdisk_slope (r));
       }
       north[0] = (-cos (phi) * sin (theta));
       north[1] = (-sin (phi) * sin (theta));
@@ -1175,6 +1214,10 @@ photo_gen_disk (p, weight, f1, f2, spectype, istart, nphot)
       p[i].freq = freqmin + rand () * dfreq;
     }
 
+    else if (disk_pdf_ok && spectype == disk_pdf_spectype && freqmin == disk_pdf_freqmin && freqmax == disk_pdf_freqmax)
+    {                           /* Use the distribution for this annulus made in disk_init */
+      p[i].freq = disk_continuum (nring, freqmin, freqmax);
+    }
     else
     {                           /* Then we will use a model which was read in */
       p[i].freq = one_continuum (spectype, disk.t[nring], log10 (disk.g[nring]), freqmin, freqmax);
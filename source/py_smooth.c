@@ -49,6 +49,9 @@
 			with -O3
 	090304	ksl	Added command line options to make it easier to do many spectra
 			at once
+	17oct		The input and output spectra are now allocated as they are needed,
+			rather than being limited to NW points, since python spectra can 
+			have any number of bins (Spectrum.nwave)
 
    *********************************************************************** */
 
@@ -62,7 +65,7 @@
 #include "python.h"
 
 
-#define NW		10000
+#define NW		10000   /* The number of points allocated for the input spectrum to start with */
 #define NSPEC           20
 
 
@@ -94,6 +97,8 @@ main (argc, argv)
   char line[LINELENGTH];
 
   int imax;                     /* number of points in input spectrum */
+  int nalloc;                   /* number of points allocated for the input spectrum */
+  int nout;                     /* number of points allocated for the output spectrum */
 
 
   int npts, i, n, nn;
@@ -109,16 +114,12 @@ main (argc, argv)
   nwords = 0;
   imax = 0;
 
-  if ((spec_in = (SpPtr) calloc (sizeof (s_dummy), NW)) == NULL)
+  nalloc = NW;
+  if ((spec_in = (SpPtr) calloc (sizeof (s_dummy), nalloc)) == NULL)
   {
     printf ("Could not allocate spec_in\n");
     exit (0);
   }
-  if ((spec_out = (SpPtr) calloc (sizeof (s_dummy), NW)) == NULL)
-  {
-    printf ("Could not allocate spec_out\n");
-    exit (0);
-  }
 
 
 /* Set initial values for everything */
@@ -207,8 +208,16 @@ main (argc, argv)
 
   xsigma = fwhm / (sqrt (8. * log (2.)));
 
+  /* The output spectrum runs one bin past wavmax, and the convolution uses the bin after that */
+  nout = (wavmax - wavmin) / res + 3;
+  if ((spec_out = (SpPtr) calloc (sizeof (s_dummy), nout)) == NULL)
+  {
+    printf ("Could not allocate spec_out for %d points\n", nout);
+    exit (0);
+  }
+
   lambda = wavmin;
-  for (npts = 0; npts < NW; npts++)
+  for (npts = 0; npts < nout - 1; npts++)
   {
     spec_out[npts].wav = lambda;
     spec_out[npts].freq = HC / (lambda * 1.e-8);
@@ -287,11 +296,15 @@ main (argc, argv)
           //                                              exit(0);
         }
         imax++;
-        if (imax > NWAVE)
-        {
-          printf ("Error: Reading input file imax > NWAVE\n");
-          exit (0);
-
+        if (imax == nalloc)
+        {                       /* Make room for more points, since the spectrum may have more than NW bins */
+          if ((spec_in = (SpPtr) realloc (spec_in, 2 * nalloc * sizeof (s_dummy))) == NULL)
+          {
+            printf ("Error: Could not allocate spec_in for more than %d points\n", nalloc);
+            exit (0);
+          }
+          memset (spec_in + nalloc, 0, nalloc * sizeof (s_dummy));
+          nalloc *= 2;
         }
       }
       else
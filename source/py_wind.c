@@ -162,7 +162,7 @@ main (argc, argv)
   char parameter_file[LINELENGTH];
   char photfile[LINELENGTH];
   double freq;
-  int interactive;
+  int interactive, parts;
 
 
   // py_wind uses rdpar, but only in an interactive mode. As a result 
@@ -238,6 +238,10 @@ main (argc, argv)
 
 /* Read in the wind file */
 
+/* Use the binary cache of the atomic data.  wind_read_select reads the atomic data for each
+windsave file, and reading a new windsave file with option N reads it a second time. */
+  atomic_cache = ATOMIC_CACHE_READ | ATOMIC_CACHE_WRITE;
+
 /* Note that wind_read allocates the space for the WindPtr array.  The
 reason that this is done in wind_read is because wind_read also reads
 the geo structure.  The geo struc contains the dimensions of the wind
@@ -249,7 +253,15 @@ be assigned.  Then w can be set to this ptr and all is restored. The
 use of w is endemic in the program. and it is always called through main.
 I did not change this now.  Though it could be done.  02apr ksl */
 
-  if (wind_read (windsavefile) < 0)
+/* The standard set of output files only needs the ion densities and scatters, so when that
+is all that is being made the rest of the variable length arrays are not read.  wind_read
+also reads the atomic data. */
+
+  parts = WIND_READ_ALL;
+  if (interactive == -1 || (interactive == 0 && strcmp (parameter_file, "NONE") == 0))
+    parts = WIND_READ_DENSITY | WIND_READ_SCATTERS;
+
+  if (wind_read_select (windsavefile, parts) < 0)
   {
     Error ("py_wind: Could not open %s", windsavefile);
     exit (0);
@@ -260,8 +272,6 @@ I did not change this now.  Though it could be done.  02apr ksl */
 
   printf ("Read wind_file %s\n", windsavefile);
 
-  get_atomic_data (geo.atomic_filename);
-
   printf ("Read Atomic data from %s\n", geo.atomic_filename);
 
 
@@ -291,7 +301,7 @@ I did not change this now.  Though it could be done.  02apr ksl */
     sprintf (root, "python%02d", i);
     strcpy (windsavefile, "");
     sprintf (windsavefile, "python%02d.wind_save", i);
-    while (wind_read (windsavefile) > 0)
+    while (wind_read_select (windsavefile, parts) > 0)
     {
       Log ("Trying %s %s\n", windsavefile, root);
       complete_file_summary (wmain, root, ochoice);
@@ -38,6 +38,9 @@ Arguments:
 	-z  	Mode to connect with zeus - it either runs two cycles in this is the first call - in order
          	to obtain a good starting state, else it runs just one cycle. In both cases, it does
 		not attempt to seek a new temperature, but it does output heating and cooling rates
+	-zs	As -z, but after the first step python stays resident and exchanges the hydro data
+		and the heating and cooling rates with zeus through the fifos root.zeus_in and
+		root.zeus_out, see zeus_server
     --version	print out python version, commit hash and if there were files with uncommitted
 	    	changes
       --rseed	set the random number seed to be time based, rather than fixed.
@@ -285,6 +288,11 @@ main (argc, argv)
 
   init_advanced_modes ();
 
+  /* Only the master process writes the cache of atomic data, to avoid all the processes writing the same file */
+
+  if (rank_global != 0)
+    atomic_cache &= ~ATOMIC_CACHE_WRITE;
+
   /* Parse the command line. Get the root. create files.diagfolder + diagfiles */
 
   restart_stat = parse_command_line (argc, argv);
@@ -466,6 +474,12 @@ main (argc, argv)
         rdint ("write_atomicdata(0=no,anything_else=yes)", &write_atomicdata);
         if (write_atomicdata)
           Log ("You have opted to save a summary of the atomic data\n");
+
+        /* atomic_cache is also defined in atomic.h; the answer is either on or off */
+        n = atomic_cache ? 1 : 0;
+        rdint ("use_atomic_cache(0=no,anything_else=yes)", &n);
+        if (n == 0)
+          atomic_cache = 0;
       }
 
       get_atomic_data (geo.atomic_filename);
@@ -652,6 +666,19 @@ main (argc, argv)
 
   if (modes.iadvanced)
   {
+    /* Should the number of photons in each band be adjusted according to how well the
+       unconverged cells were sampled in the previous cycle */
+    rdint ("Photon_sampling.adaptive(0=no,1=yes)", &geo.adaptive_bands);
+    if (geo.adaptive_bands)
+    {
+      rddoub ("Photon_sampling.adaptive_fraction(0-0.9)", &geo.adaptive_fraction);
+      if (geo.adaptive_fraction < 0.0 || geo.adaptive_fraction > 0.9)
+      {
+        Error ("python: Photon_sampling.adaptive_fraction %g must lie between 0 and 0.9\n", geo.adaptive_fraction);
+        exit (0);
+      }
+    }
+
     /* Do we require extra diagnostics or not */
     rdint ("Extra.diagnostics(0=no,1=yes) ", &modes.diag_on_off);
     if (modes.diag_on_off)
@@ -796,7 +823,12 @@ main (argc, argv)
   //and allows routines to act accordinaly.
 /* 67 -ksl- geo.wycle will start at zero unless we are completing an old run */
 /* XXXX -  CALCULATE THE IONIZATION OF THE WIND */
+  perf_init (restart_stat);
   calculate_ionization (restart_stat);
+
+  /* In zeus server mode the remaining hydro steps are carried out here, without restarting */
+  if (modes.zeus_server)
+    zeus_server (geo.hydro_domain_number);
 /* XXXX - END OF CYCLE TO CALCULATE THE IONIZATION OF THE WIND */
   Log (" Completed wind creation.  The elapsed TIME was %f\n", timer ());
   /* SWM - Evaluate wind paths for last iteration */
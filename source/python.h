@@ -26,6 +26,17 @@ are certain times we want to loop over everything.  The situation with NPLASMA i
 int NDIM2;                      //The total number of wind cells in wmain
 int NPLASMA;                    //The number of cells with non-zero volume or the size of plasma structure
 
+/* The parts of a windsave file which wind_read_select can be asked to read, beyond geo, the domains,
+   wmain, the disk and the fixed part of plasmamain which are always read.  Parts which are not read
+   are skipped over in the file, and the corresponding arrays left as zero */
+#define WIND_READ_DENSITY   1       // plasmamain[].density and partition
+#define WIND_READ_RATES     2       // the PW arrays, ioniz, recomb, inner_recomb, heat_ion, lum_ion, lum_inner_ion
+#define WIND_READ_SCATTERS  4       // plasmamain[].scatters and xscatters
+#define WIND_READ_LEVELS    8       // plasmamain[].levden, recomb_simple and kbf_use
+#define WIND_READ_MACRO     16      // macromain and the macro atom estimators
+#define WIND_READ_ALL       31
+#define WIND_READ_KEEP_ATOMIC 32    // don't read the atomic data again if it is from the same file as last time
+
 char basename[132];             // The root of the parameter file name being used by python
 
 /* These are tunable parameters that control various aspects of python
@@ -88,7 +99,7 @@ double DENSITY_PHOT_MIN;        /* This constant is a minimum density for the pu
 
 int NPHOT;                      /* The number of photon bundles created.  defined in python.c */
 
-#define NWAVE  			       10000    //Increasing from 4000 to 10000 (SS June 04)
+#define NWAVE  			       10000    //Increasing from 4000 to 10000 (SS June 04).  The default for geo.nwave
 #define MAXSCAT 			50
 
 /* Define the structures */
@@ -202,6 +213,8 @@ typedef struct domain
   int log_linear;               /*0 -> the grid spacing will be logarithmic in x and z, 1-> linear */
   double xlog_scale, zlog_scale;        /* Scale factors for setting up a logarithmic grid, the [1,1] cell
                                            will be located at xlog_scale,zlog_scale */
+  double adapt_grid;            /* If > 0, the strength with which cylindrical grid lines are concentrated
+                                   where the density and velocity change rapidly, see cylind_adapt_grid */
 
   /* The next few structures define the boundaries of an emission region */
   struct cone windcone[2];      /* The cones that define the boundary of winds like SV or kwd */
@@ -219,6 +232,9 @@ typedef struct domain
   double wind_z_var[NDIM_MAX][NDIM_MAX];
   double wind_midz_var[NDIM_MAX][NDIM_MAX];
 
+  int wig_i, wig_j;             /* The grid indices last found by where_in_grid, used as the starting point for the next search */
+  int cf_i[2], cf_j[2];         /* The same for coord_locate, for the vertex (0) and midpoint (1) grids */
+
 
 /* Since in principle we can mix and match arbitrarily the next parameters now have to be part of the domain structure */
 
@@ -540,8 +556,33 @@ struct geometry
   int reverb_dump_cells;        //SWM - Number of cells to dump, list of cells to dump 'nwind' values
   double *reverb_dump_x, *reverb_dump_z;        //SWM - x & z values of the cells to dump
   int reverb_lines, *reverb_line;       //SWM - Number of lines to track, and array of line 'nres' values
+  enum reverb_dump_enum
+  { REV_DUMP_TEXT = 0, REV_DUMP_BINARY = 1 } reverb_dump;       // Format of the delay dump file, see delay_dump_prep
+  int reverb_tf;                // Bin photons into a transfer function in memory instead of dumping them, see reverb_tf_init
+  int reverb_tf_nfreq, reverb_tf_ndelay;        // Number of frequency and delay bins in the transfer function
+  double reverb_tf_delay_max;   // Maximum delay in the transfer function (s)
 
   int spec_mod;                 //A flag to say that we do hav spectral models
+
+  /* Parameters for the incremental wind update, in which cells that have converged and whose
+   * radiation field has not changed by more than the Monte Carlo noise are not re-solved */
+  int incremental_update;       /* 0 = update every cell every cycle (the default), 1 = incremental */
+  int incremental_refresh;      /* Every cell is updated on cycles which are a multiple of this */
+  double incremental_nsigma;    /* Change in an estimator, in units of its expected noise, which forces an update */
+
+  /* Parameters for adaptive sampling, which moves photons during ionization cycles into the bands
+   * which were poorly sampled in unconverged cells in the previous cycle */
+  int adaptive_bands;           /* 0 = fixed band fractions (the default), 1 = adaptive */
+  double adaptive_fraction;     /* The fraction of the photons which are distributed adaptively */
+
+  double extract_rr_tau;        /* The optical depth interval at which Russian roulette is played in extract_one, 0 for none */
+
+  /* Parameters of the optional table of optical depths to the observers used in the spectral cycles */
+  int extract_tau_table;        /* 0 = integrate every path (the default), 1 = use the table */
+  int extract_tau_nfreq, extract_tau_naz;       /* The number of frequencies and azimuths in the table */
+  int extract_tau_check;        /* Every extract_tau_check'th photon is integrated exactly to estimate the error */
+
+  int nwave;                    /* The number of frequency bins in the spectra */
 }
 geo;
 
@@ -585,13 +626,18 @@ blmod;
     For each frequency:
       For each path bin:
         What's the total fluxback of all these photons entering the cell?
+    Most cells only see photons in a few of the path bins, so only the bins which have been
+    hit are stored, in order of bin.  See wind_paths_add_bin.
 */
 typedef struct wind_paths
 {
-  double *ad_path_flux;         //Array[by frequency, then path] of total flux of photons with the given v&p
-  int *ai_path_num;             //Array[by frequency, then path] of the number of photons in this bin
+  int i_nbins, i_nalloc;        //Number of path bins that have been hit, and the space allocated for them
+  int *ai_bin;                  //Array of the path bins that have been hit, in increasing order
+  double *ad_path_flux;         //Array of total flux of photons in each of these bins
+  int *ai_path_num;             //Array of the number of photons in each of these bins
   double d_flux, d_path;        //Total flux, average path
   int i_num;                    //Number of photons hitting this cell
+  struct Alias *alias;          //Alias table of the path bins weighted by flux, made by wind_paths_evaluate_single
 } wind_paths_dummy, *Wind_Paths_Ptr;
 
 /* 	This structure defines the wind.  The structure w is allocated in the main
@@ -664,6 +710,15 @@ wind_dummy, *WindPtr;
 
 WindPtr wmain;
 
+/* Bilinear coefficients for the velocity in each cell, so that vwind_xyz need only evaluate
+   v = c0 + c1 dr + c2 dz + c3 dr dz.  There are 12 for each element of wmain, 4 for each component 
+   of v.  They are made by vwind_coef_init, and must be remade whenever wmain[].v changes */
+double *vwind_coef;
+int vwind_coef_ok;
+
+/* TRUE if the boundaries of the wind used by ds_to_wind are up to date, see ds_to_wind_init */
+int wind_bounds_ok;
+
 /* 57+ - 06jun -- plasma is a new structure that contains information about the properties of the
 plasma in regions of the geometry that are actually included n the wind */
 
@@ -832,6 +887,13 @@ typedef struct plasma
   double ferland_ip;            /* IP calculaterd from equation 5.4 in hazy1 - assuming allphotons come from 0,0,0 and the wind is transparent */
   double ip;                    /*NSH 111004 Ionization parameter calculated as number of photons over the lyman limit entering a cell, divided by the number density of hydrogen for the cell */
   double xi;                    /*NSH 151109 Ionization parameter as defined by Tartar et al 1969 and described in Hazy. Its the ionizing flux over the number of hydrogen atoms */
+
+  /* Used by the incremental wind update.  These are the values of the radiation field estimators
+     the last time the ionization and temperature of the cell were actually solved for */
+  double j_ref, ave_freq_ref, ip_ref;
+  double xj_ref[NXBANDS];
+  int ncycles_converged;        /* The number of successive updates in which the cell was converged */
+  int nskip_update;             /* The number of successive cycles in which the cell has not been updated */
 } plasma_dummy, *PlasmaPtr;
 
 PlasmaPtr plasmamain;
@@ -939,6 +1001,7 @@ int size_Jbar_est, size_gamma_est, size_alpha_est;
 #define FRACTIONAL_ERROR 0.03   //The change in n_e which causes a break out of the loop for ne
 #define THETAMAX	 1e4    //Used in initial calculation of n_e
 #define MIN_TEMP	100.    //  ??? this is another minimum temperature - it is used as the minimum tempersture in (JM -- in what??)
+#define INCREMENTAL_NCONVERGED 2        // Cycles a cell must have been converged before the incremental update may skip it
 
 // these definitions are for various ionization modes
 #define IONMODE_ML93_FIXTE 0    // Lucy Mazzali using existing t_e (no HC balance)
@@ -1062,6 +1125,12 @@ int nspectra;                   /* After create_spectrum, the number of elements
                                    general s[0],s[1] and s[2] are the escaping, scattered and absorbed photons,
                                    while elements higher than this will contain spectra as seen by different observers */
 
+double *reverb_tf;              /* The transfer function, reverb_tf_nspec x geo.reverb_tf_nfreq x geo.reverb_tf_ndelay
+                                   bins for the extracted spectra, if geo.reverb_tf is set.  See reverb_tf_init */
+int reverb_tf_nspec;
+
+#include "perf.h"
+
 
 int nscat[MAXSCAT + 1], nres[MAXSCAT + 1], nstat[NSTAT];
 
@@ -1087,13 +1156,13 @@ typedef struct spectrum
                                    >0     -> select only photons whose "last" position is above the disk
                                    <0    -> select only photons whose last position is below the disk */
   double x[3], r;               /* The position and radius of a special region from which to extract spectra  */
-  double f[NWAVE];
-  double lf[NWAVE];             /* a second array to hole the extracted spectrum in log units */
-  double lfreq[NWAVE];          /* We need to hold what freqeuncy intervals our logarithmic spectrum has been taken over */
+  int nwave;                    /* The number of frequency bins in each of the arrays below, see spectrum_alloc */
+  double *f;
+  double *lf;                   /* a second array to hole the extracted spectrum in log units */
 
-  double f_wind[NWAVE];         /* The spectrum of photons created in the wind or scattered in the wind. Created for 
+  double *f_wind;               /* The spectrum of photons created in the wind or scattered in the wind. Created for 
                                    reflection studies but possible useful for other reasons as well. */
-  double lf_wind[NWAVE];        /* The logarithmic version of this */
+  double *lf_wind;              /* The logarithmic version of this */
 }
 spectrum_dummy, *SpecPtr;
 
@@ -1134,6 +1203,19 @@ typedef struct Pdf
  *PdfPtr, pdf_dummy;
 
 
+/* An alias table, made by alias_gen, from which one of n discrete outcomes can be drawn with
+   a probability proportional to its weight, in a time which does not depend on n */
+typedef struct Alias
+{
+  int n;                        /* The number of outcomes */
+  int nalloc;                   /* The size of prob and alias as allocated */
+  double *prob;                 /* The probability of keeping outcome i once column i is chosen */
+  int *alias;                   /* The outcome which is returned otherwise */
+  double total;                 /* The sum of the weights */
+}
+ *AliasPtr, alias_dummy;
+
+
 /* Variable used to allow something to be printed out the first few times
    an even occurs */
 int itest, jtest;
@@ -1163,6 +1245,25 @@ as part of effort to incorporate anisotropic scattering in to python.
 Added for python_43.2 */
 
 
+/* Cumulative distributions of the model spectra of each disk annulus, built by disk_pdf_init so
+   that photo_gen_disk does not have to construct a new one for each photon */
+
+struct Pdf disk_pdf[NRINGS];
+double disk_pdf_t[NRINGS], disk_pdf_g[NRINGS]; /* The temperature and log g for which each was made */
+double disk_pdf_freqmin, disk_pdf_freqmax;
+int disk_pdf_spectype;
+int disk_pdf_ok;                /* TRUE if disk_pdf describes the current disk annulae */
+
+/* Alias tables for choosing the wind cell, and for macro atoms the level, from which wind photons 
+   are generated.  alias_kpkt and alias_matom are indexed by the element of wmain, and are made by 
+   matom_alias_init once the emissivities are known.  alias_matom_level has one table for each 
+   plasma cell.  alias_wind is remade by photo_gen_wind for each band. */
+
+struct Alias alias_kpkt, alias_matom, alias_wind;
+struct Alias *alias_matom_level;
+int alias_matom_nplasma;        /* The number of elements of alias_matom_level */
+
+
 /* Provide generally for having arrays which descibe the 3 xyz axes. 
 these are initialized in main, and used in anisowind  */
 
@@ -1187,6 +1288,7 @@ struct xbands
   double weight[NBANDS];
   int nphot[NBANDS];
   int nbands;                   // Actual number of bands in use
+  double adapt_fraction[NBANDS];        // The fraction of photons the adaptive sampling would like in each band
 }
 xband;
 
@@ -1252,6 +1354,12 @@ int ncell_stats[NCSTAT];        //the numbers of the cells we are going to log
 int nerr_no_Jmodel;
 int nerr_Jmodel_wrong_freq;
 
+/* Counters for the temperature solvers, calc_te and temp_func_solve, reported by wind_update */
+int nte_solve_calls;
+int nte_solve_evals;
+int npair_temp_calls;
+int npair_temp_evals;
+
 
 
 // advanced mode variables
@@ -1273,6 +1381,7 @@ struct advanced_modes
   int quit_after_inputs;        // quit after inputs read in, testing mode
   int fixed_temp;               // do not alter temperature from that set in the parameter file
   int zeus_connect;             // We are connecting to zeus, do not seek new temp and output a heating and cooling file
+  int zeus_server;              // Stay resident after the first zeus step and exchange hydro data through fifos
   int rand_seed_usetime;        // default random number seed is fixed, not based on time
 }
 modes;
@@ -1305,6 +1414,7 @@ struct filenames
   char spec_wind[LINELENGTH];   // .spec file for wind photons
   char lspec[LINELENGTH];       // .spec file
   char lspec_wind[LINELENGTH];  // .spec file for wind photons
+  char perf[LINELENGTH];        // .perf file of timings and counters for each cycle
 }
 files;
 
@@ -9,6 +9,7 @@
 #include <math.h>
 #include "recipes.h"
 #include "log.h"
+#include "perf.h"
 
 
 
@@ -43,6 +44,7 @@ qromb (func, a, b, eps)
   void polint ();
 
   ss = 0.0;
+  perf_count[PERF_QROMB]++;
   if (a >= b)
   {
     Error ("Error qromb: a %e>=b %e\n", a, b);
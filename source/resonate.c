@@ -305,6 +305,7 @@ method). If the macro atom method is not used just get kap_bf to 0 and move on).
 
     if (0. < x && x < 1.)
     {                           /* this particular line is in resonance */
+      perf_count[PERF_RESONANCES]++;
       ds = x * smax;
 
 
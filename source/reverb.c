@@ -19,6 +19,26 @@ int delay_dump_bank_size = 65535, delay_dump_bank_curr = 0;
 PhotPtr delay_dump_bank;
 int *delay_dump_bank_ex;
 
+/* Column buffers for the binary delay dump.  Rows are gathered into chunks
+ * of up to #DELAY_DUMP_CHUNK rows, each of which is written as one record. */
+#define DELAY_DUMP_CHUNK 65536
+#define DELAY_DUMP_MAGIC "PYDELAY"
+#define DELAY_DUMP_NDOUBLE 3
+#define DELAY_DUMP_NINT 6
+int delay_dump_nrows = 0, delay_dump_is_open = 0;
+double *delay_dump_col_d;
+int *delay_dump_col_i;
+FILE *delay_dump_fptr;
+#ifdef MPI_ON
+MPI_File delay_dump_fh;
+#endif
+
+/* The in-memory transfer function, used instead of the delay dump
+ * if geo.reverb_tf is set.  See reverb_tf_init. */
+#define REVERB_TF_MAGIC "PYTF"
+double reverb_tf_fmin, reverb_tf_dfreq, reverb_tf_ddelay;
+long reverb_tf_lost;
+
 /**********************************************************/
 /** @name 	delay_to_observer
  * @brief	Calculates the delay to the observer plane
@@ -71,9 +91,33 @@ delay_dump_prep (int restart_stat, int i_rank)
   char string[LINELENGTH], c_file[LINELENGTH], c_rank[LINELENGTH];
   int i;
 
+  if (geo.reverb_tf)
+  {                             //Photons are binned into the transfer function instead of being dumped
+    reverb_tf_init (restart_stat);
+    if (geo.reverb_tf)
+      return (0);
+  }
+
+  //Allocate and zero dump files and set extract status.  These stage extracted photons in both formats
+  delay_dump_bank = (PhotPtr) calloc (sizeof (p_dummy), delay_dump_bank_size);
+  delay_dump_bank_ex = (int *) calloc (sizeof (int), delay_dump_bank_size);
+  if (delay_dump_bank == NULL || delay_dump_bank_ex == NULL)
+  {
+    Error ("delay_dump_prep: Unable to allocate the delay dump bank\n");
+    exit (0);
+  }
+  for (i = 0; i < delay_dump_bank_size; i++)
+    delay_dump_bank_ex[i] = 0;
+  delay_dump_bank_curr = 0;
+
   //Get output filename
   strcpy (c_file, files.root);  //Copy filename to new string
   strcat (c_file, ".delay_dump");
+  if (geo.reverb_dump == REV_DUMP_BINARY)
+  {                             //All threads write to the same binary file
+    strcpy (delay_dump_file, c_file);
+    return (delay_dump_binary_open (restart_stat));
+  }
   if (i_rank > 0)
   {
     sprintf (c_rank, "%i", i_rank);     //Write thread to string
@@ -81,12 +125,6 @@ delay_dump_prep (int restart_stat, int i_rank)
   }
   strcpy (delay_dump_file, c_file);     //Store modified filename for later
 
-  //Allocate and zero dump files and set extract status
-  delay_dump_bank = (PhotPtr) calloc (sizeof (p_dummy), delay_dump_bank_size);
-  delay_dump_bank_ex = (int *) calloc (sizeof (int), delay_dump_bank_size);
-  for (i = 0; i < delay_dump_bank_size; i++)
-    delay_dump_bank_ex[i] = 0;
-
   if (restart_stat == 1)
   {                             //Check whether the output file already has a header
     Log ("delay_dump_prep: Resume run, skipping writeout\n");
@@ -130,12 +168,16 @@ delay_dump_prep (int restart_stat, int i_rank)
 int
 delay_dump_finish (void)
 {
+  if (geo.reverb_tf)
+    return (0);
   if (delay_dump_bank_curr > 0)
   {
-    delay_dump (delay_dump_bank, delay_dump_bank_curr - 1, 1);
+    delay_dump (delay_dump_bank, delay_dump_bank_curr, 1);
   }
   free (delay_dump_bank);
   free (delay_dump_bank_ex);
+  if (geo.reverb_dump == REV_DUMP_BINARY)
+    delay_dump_binary_close ();
   return (0);
 }
 
@@ -209,11 +251,14 @@ delay_dump (PhotPtr p, int np, int iExtracted)
   double zangle, delay;
   subzero = 0;
 
+  if (geo.reverb_tf && geo.select_extract)
+    return (0);                 //Extracted photons were added to the transfer function by extract_one()
   printf ("delay_dump: Dumping %d photons\n", np);
   /*
    * Open a file for writing the spectrum
    */
-  if ((fptr = fopen (delay_dump_file, "a")) == NULL)
+  fptr = NULL;
+  if (!geo.reverb_tf && geo.reverb_dump == REV_DUMP_TEXT && (fptr = fopen (delay_dump_file, "a")) == NULL)
   {
     Error ("delay_dump: Unable to reopen %s for writing\n", delay_dump_file);
     exit (0);
@@ -246,12 +291,17 @@ delay_dump (PhotPtr p, int np, int iExtracted)
             if (delay < 0)
               subzero++;
 
-            fprintf (fptr,
-                     "%10.5g %10.5g %10.5g %+10.5g %+10.5g %+10.5g %3d     %3d     %10.5g %5d %5d %5d %10d\n",
-                     p[nphot].freq, C * 1e8 / p[nphot].freq, p[nphot].w,
-                     p[nphot].x[0], p[nphot].x[1], p[nphot].x[2],
-                     p[nphot].nscat, p[nphot].nrscat, delay,
-                     (iExtracted ? delay_dump_bank_ex[nphot] : 0), i - MSPEC, p[nphot].origin, p[nphot].nres);
+            if (geo.reverb_tf)
+              reverb_tf_add (i - MSPEC, p[nphot].freq, delay, p[nphot].w);
+            else if (geo.reverb_dump == REV_DUMP_BINARY)
+              delay_dump_row (&p[nphot], delay, i - MSPEC, (iExtracted ? delay_dump_bank_ex[nphot] : 0));
+            else
+              fprintf (fptr,
+                       "%10.5g %10.5g %10.5g %+10.5g %+10.5g %+10.5g %3d     %3d     %10.5g %5d %5d %5d %10d\n",
+                       p[nphot].freq, C * 1e8 / p[nphot].freq, p[nphot].w,
+                       p[nphot].x[0], p[nphot].x[1], p[nphot].x[2],
+                       p[nphot].nscat, p[nphot].nrscat, delay,
+                       (iExtracted ? delay_dump_bank_ex[nphot] : 0), i - MSPEC, p[nphot].origin, p[nphot].nres);
           }
         }
       }
@@ -262,7 +312,8 @@ delay_dump (PhotPtr p, int np, int iExtracted)
   {
     Log ("delay_dump: %d photons with <0 delay found! Increase path bin resolution to minimise this error\n", subzero);
   }
-  fclose (fptr);
+  if (fptr != NULL)
+    fclose (fptr);
   return (0);
 }
 
@@ -299,3 +350,358 @@ delay_dump_single (PhotPtr pp, int extract_phot)
   }
   return (0);
 }
+
+/**********************************************************/
+/** @name 	delay_dump_binary_open
+ * @brief	Opens the binary delay dump file
+ *
+ * @param [in] restart_stat If this is a restart run
+ * @return 					0
+ *
+ * The binary delay dump is a single file, root.delay_dump,
+ * shared by all threads.  It starts with the 8 character
+ * string PYDELAY followed by 3 ints: the format version and
+ * the number of double and int columns.  It then consists
+ * of chunks, each of which is an int giving the number of
+ * rows n followed by the columns, each of n values:
+ *
+ *   double: Freq, Weight, Delay
+ *   int:    Spectrum, Origin, Last_Res, Scatters, RScatter, Extracted
+ *
+ * These are the columns of the text format, without the
+ * wavelength and last position.  Chunks from different
+ * threads may be interleaved but are never split, as each
+ * is written with a single MPI_File_write_shared call.
+ * The file is opened collectively, so this must be called
+ * by every thread.
+ *
+ * @notes
+ * The columns are not compressed, since that would add a
+ * dependency on a compression library.
+***********************************************************/
+int
+delay_dump_binary_open (int restart_stat)
+{
+  char magic[8];
+  int head[3];
+
+  if (delay_dump_is_open)
+    return (0);
+
+  delay_dump_col_d = (double *) calloc (sizeof (double), DELAY_DUMP_NDOUBLE * DELAY_DUMP_CHUNK);
+  delay_dump_col_i = (int *) calloc (sizeof (int), DELAY_DUMP_NINT * DELAY_DUMP_CHUNK);
+  if (delay_dump_col_d == NULL || delay_dump_col_i == NULL)
+  {
+    Error ("delay_dump_binary_open: Unable to allocate the column buffers\n");
+    exit (0);
+  }
+  delay_dump_nrows = 0;
+
+  memset (magic, 0, sizeof (magic));
+  strcpy (magic, DELAY_DUMP_MAGIC);
+  head[0] = 1;
+  head[1] = DELAY_DUMP_NDOUBLE;
+  head[2] = DELAY_DUMP_NINT;
+
+#ifdef MPI_ON
+  if (MPI_File_open (MPI_COMM_WORLD, delay_dump_file,
+                     MPI_MODE_WRONLY | MPI_MODE_CREATE | (restart_stat == 1 ? MPI_MODE_APPEND : 0), MPI_INFO_NULL, &delay_dump_fh) != MPI_SUCCESS)
+  {
+    Error ("delay_dump_binary_open: Unable to open %s for writing\n", delay_dump_file);
+    exit (0);
+  }
+  if (restart_stat != 1)
+  {
+    MPI_File_set_size (delay_dump_fh, 0);
+    if (rank_global == 0)
+    {
+      MPI_File_write_shared (delay_dump_fh, magic, sizeof (magic), MPI_BYTE, MPI_STATUS_IGNORE);
+      MPI_File_write_shared (delay_dump_fh, head, 3, MPI_INT, MPI_STATUS_IGNORE);
+    }
+  }
+  MPI_Barrier (MPI_COMM_WORLD); //Make sure the header is first in the file
+#else
+  if ((delay_dump_fptr = fopen (delay_dump_file, restart_stat == 1 ? "ab" : "wb")) == NULL)
+  {
+    Error ("delay_dump_binary_open: Unable to open %s for writing\n", delay_dump_file);
+    exit (0);
+  }
+  if (restart_stat != 1)
+  {
+    fwrite (magic, sizeof (magic), 1, delay_dump_fptr);
+    fwrite (head, sizeof (int), 3, delay_dump_fptr);
+  }
+#endif
+
+  delay_dump_is_open = 1;
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	delay_dump_row
+ * @brief	Adds one row to the binary delay dump
+ *
+ * @param [in] pp			Photon to record
+ * @param [in] delay		Delay of the photon
+ * @param [in] nspec		Spectrum (angle) the photon contributes to
+ * @param [in] extracted	Whether this is an extracted photon
+ * @return 					0
+***********************************************************/
+int
+delay_dump_row (PhotPtr pp, double delay, int nspec, int extracted)
+{
+  int n;
+
+  n = delay_dump_nrows;
+  delay_dump_col_d[n] = pp->freq;
+  delay_dump_col_d[DELAY_DUMP_CHUNK + n] = pp->w;
+  delay_dump_col_d[2 * DELAY_DUMP_CHUNK + n] = delay;
+  delay_dump_col_i[n] = nspec;
+  delay_dump_col_i[DELAY_DUMP_CHUNK + n] = pp->origin;
+  delay_dump_col_i[2 * DELAY_DUMP_CHUNK + n] = pp->nres;
+  delay_dump_col_i[3 * DELAY_DUMP_CHUNK + n] = pp->nscat;
+  delay_dump_col_i[4 * DELAY_DUMP_CHUNK + n] = pp->nrscat;
+  delay_dump_col_i[5 * DELAY_DUMP_CHUNK + n] = extracted;
+
+  if (++delay_dump_nrows == DELAY_DUMP_CHUNK)
+    delay_dump_flush ();
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	delay_dump_flush
+ * @brief	Writes the buffered rows as one chunk
+ *
+ * @return 					0
+ *
+ * Packs the used part of each column into one buffer so
+ * that the chunk can be written in a single call.
+***********************************************************/
+int
+delay_dump_flush (void)
+{
+  char *buf, *b;
+  int n, nbytes;
+
+  if (delay_dump_nrows == 0)
+    return (0);
+
+  nbytes = sizeof (int) + delay_dump_nrows * (DELAY_DUMP_NDOUBLE * sizeof (double) + DELAY_DUMP_NINT * sizeof (int));
+  if ((buf = malloc (nbytes)) == NULL)
+  {
+    Error ("delay_dump_flush: Unable to allocate %d bytes\n", nbytes);
+    exit (0);
+  }
+
+  b = buf;
+  memcpy (b, &delay_dump_nrows, sizeof (int));
+  b += sizeof (int);
+  for (n = 0; n < DELAY_DUMP_NDOUBLE; n++)
+  {
+    memcpy (b, &delay_dump_col_d[n * DELAY_DUMP_CHUNK], delay_dump_nrows * sizeof (double));
+    b += delay_dump_nrows * sizeof (double);
+  }
+  for (n = 0; n < DELAY_DUMP_NINT; n++)
+  {
+    memcpy (b, &delay_dump_col_i[n * DELAY_DUMP_CHUNK], delay_dump_nrows * sizeof (int));
+    b += delay_dump_nrows * sizeof (int);
+  }
+
+#ifdef MPI_ON
+  MPI_File_write_shared (delay_dump_fh, buf, nbytes, MPI_BYTE, MPI_STATUS_IGNORE);
+#else
+  if (fwrite (buf, 1, nbytes, delay_dump_fptr) != (size_t) nbytes)
+    Error ("delay_dump_flush: Problem writing to %s\n", delay_dump_file);
+#endif
+
+  free (buf);
+  delay_dump_nrows = 0;
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	delay_dump_binary_close
+ * @brief	Writes any remaining rows and closes the binary delay dump
+ *
+ * @return 					0
+ *
+ * Like delay_dump_binary_open, this must be called by every
+ * thread.
+***********************************************************/
+int
+delay_dump_binary_close (void)
+{
+  if (!delay_dump_is_open)
+    return (0);
+
+  delay_dump_flush ();
+#ifdef MPI_ON
+  MPI_File_close (&delay_dump_fh);
+#else
+  fclose (delay_dump_fptr);
+#endif
+  free (delay_dump_col_d);
+  free (delay_dump_col_i);
+  delay_dump_is_open = 0;
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	reverb_tf_init
+ * @brief	Allocates the in-memory transfer function
+ *
+ * @param [in] restart_stat If this is a restart run
+ * @return 					0
+ *
+ * The transfer function is a grid of #reverb_tf_nfreq linear
+ * frequency bins between the limits of the spectra, by
+ * #reverb_tf_ndelay linear delay bins between 0 and
+ * geo.reverb_tf_delay_max, for each of the extracted spectra.
+ * Photons that would have been written to the delay dump are
+ * instead added to this grid by reverb_tf_add().
+ *
+ * If this is a restart partway through the spectral cycles,
+ * the grid saved by the previous run is read back, so that it
+ * carries on building up in the same way as the spectra.
+***********************************************************/
+int
+reverb_tf_init (int restart_stat)
+{
+  FILE *fptr;
+  char c_file[LINELENGTH];
+  long nbins;
+  int head[4];
+  double range[3];
+
+  if (reverb_tf != NULL)
+    return (0);
+
+  reverb_tf_nspec = geo.nangles;       // The extracted spectra; nspectra is not set until spectrum_init
+  if (reverb_tf_nspec < 1)
+  {
+    Error ("reverb_tf_init: There are no extracted spectra, so no transfer function will be made\n");
+    geo.reverb_tf = 0;
+    return (0);
+  }
+  reverb_tf_fmin = C / (geo.swavemax * 1.e-8);
+  reverb_tf_dfreq = (C / (geo.swavemin * 1.e-8) - reverb_tf_fmin) / geo.reverb_tf_nfreq;
+  reverb_tf_ddelay = geo.reverb_tf_delay_max / geo.reverb_tf_ndelay;
+  reverb_tf_lost = 0;
+
+  nbins = (long) reverb_tf_nspec * geo.reverb_tf_nfreq * geo.reverb_tf_ndelay;
+  if ((reverb_tf = (double *) calloc (sizeof (double), nbins)) == NULL)
+  {
+    Error ("reverb_tf_init: Unable to allocate %ld bins for the transfer function\n", nbins);
+    exit (0);
+  }
+  Log ("reverb_tf_init: Transfer function of %d x %d bins for %d spectra, %.2e MB\n",
+       geo.reverb_tf_nfreq, geo.reverb_tf_ndelay, reverb_tf_nspec, nbins * sizeof (double) / 1e6);
+
+  if (restart_stat == 1 && geo.pcycle > 0)
+  {                             //Pick up the transfer function from the cycles that have already been run
+    strcpy (c_file, files.root);
+    strcat (c_file, ".tf");
+    if ((fptr = fopen (c_file, "rb")) == NULL
+        || fread (c_file, 1, 8, fptr) != 8 || strncmp (c_file, REVERB_TF_MAGIC, 8) != 0
+        || fread (head, sizeof (int), 4, fptr) != 4 || fread (range, sizeof (double), 3, fptr) != 3
+        || head[0] != reverb_tf_nspec || head[1] != geo.reverb_tf_nfreq || head[2] != geo.reverb_tf_ndelay
+        || fread (reverb_tf, sizeof (double), nbins, fptr) != (size_t) nbins)
+    {
+      Error ("reverb_tf_init: Unable to read the transfer function from %s.tf, starting again\n", files.root);
+      memset (reverb_tf, 0, nbins * sizeof (double));
+    }
+    if (fptr != NULL)
+      fclose (fptr);
+  }
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	reverb_tf_add
+ * @brief	Adds a photon to the transfer function
+ *
+ * @param [in] nspec		Spectrum (angle) the photon contributes to
+ * @param [in] freq			Frequency of the photon
+ * @param [in] delay		Delay of the photon
+ * @param [in] w			Weight of the photon
+ * @return 					0
+ *
+ * Photons with negative delays, which come from the finite
+ * resolution of the path distributions, go in the first delay
+ * bin.  Photons outside the frequency range or beyond the
+ * maximum delay are not recorded but are counted.
+***********************************************************/
+int
+reverb_tf_add (int nspec, double freq, double delay, double w)
+{
+  int ifreq, idelay;
+
+  ifreq = (freq - reverb_tf_fmin) / reverb_tf_dfreq;
+  idelay = (delay > 0.0 ? delay / reverb_tf_ddelay : 0);
+  if (ifreq < 0 || ifreq >= geo.reverb_tf_nfreq || idelay >= geo.reverb_tf_ndelay)
+  {
+    reverb_tf_lost++;
+    return (0);
+  }
+  reverb_tf[((long) nspec * geo.reverb_tf_nfreq + ifreq) * geo.reverb_tf_ndelay + idelay] += w;
+  return (0);
+}
+
+/**********************************************************/
+/** @name 	reverb_tf_save
+ * @brief	Writes the transfer function to root.tf
+ *
+ * @return 					0
+ *
+ * The file starts with the 8 character string PYTF followed
+ * by 4 ints: the number of spectra, frequency bins and delay
+ * bins, and the number of spectral cycles completed.  Then
+ * come 3 doubles giving the minimum and maximum frequency and
+ * the maximum delay, then the grid itself, with the delay
+ * varying fastest and the spectrum slowest.
+ *
+ * Like the spectra, the grid is the sum over the cycles run so
+ * far, so it should be multiplied by the total number of
+ * spectral cycles over the number completed before use.  This
+ * is called by the master thread after the grid has been
+ * gathered with gather_tf_para().
+***********************************************************/
+int
+reverb_tf_save (void)
+{
+  FILE *fptr;
+  char c_file[LINELENGTH], magic[8];
+  long nbins;
+  int head[4];
+  double range[3];
+
+  strcpy (c_file, files.root);
+  strcat (c_file, ".tf");
+  if ((fptr = fopen (c_file, "wb")) == NULL)
+  {
+    Error ("reverb_tf_save: Unable to open %s for writing\n", c_file);
+    return (0);
+  }
+
+  memset (magic, 0, sizeof (magic));
+  strcpy (magic, REVERB_TF_MAGIC);
+  head[0] = reverb_tf_nspec;
+  head[1] = geo.reverb_tf_nfreq;
+  head[2] = geo.reverb_tf_ndelay;
+  head[3] = geo.pcycle;
+  range[0] = reverb_tf_fmin;
+  range[1] = reverb_tf_fmin + geo.reverb_tf_nfreq * reverb_tf_dfreq;
+  range[2] = geo.reverb_tf_delay_max;
+  nbins = (long) reverb_tf_nspec * geo.reverb_tf_nfreq * geo.reverb_tf_ndelay;
+
+  fwrite (magic, sizeof (magic), 1, fptr);
+  fwrite (head, sizeof (int), 4, fptr);
+  fwrite (range, sizeof (double), 3, fptr);
+  if (fwrite (reverb_tf, sizeof (double), nbins, fptr) != (size_t) nbins)
+    Error ("reverb_tf_save: Problem writing to %s\n", c_file);
+  fclose (fptr);
+
+  if (reverb_tf_lost > 0)
+    Log ("reverb_tf_save: %ld photons fell outside the transfer function so far on this thread\n", reverb_tf_lost);
+  return (0);
+}
@@ -534,7 +534,6 @@ rtheta_where_in_grid (ndom, x)
 {
   int i, j, n;
   double r, theta;
-  double f;
   int ndim, mdim;
 
   ndim = zdom[ndom].ndim;
@@ -554,9 +553,9 @@ rtheta_where_in_grid (ndom, x)
     return (-1);                /*x is inside grid */
   }
 
-  /* Locate the position in i and j */
-  fraction (r, zdom[ndom].wind_x, ndim, &i, &f, 0);
-  fraction (theta, zdom[ndom].wind_z, mdim, &j, &f, 0);
+  /* Locate the position in i and j, starting from the last cell found */
+  i = zdom[ndom].wig_i = fraction_guess (r, zdom[ndom].wind_x, ndim, zdom[ndom].wig_i);
+  j = zdom[ndom].wig_j = fraction_guess (theta, zdom[ndom].wind_z, mdim, zdom[ndom].wig_j);
 
   /* Convert i,j back to n */
 
@@ -31,6 +31,9 @@ History:
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "atomic.h"
 
 
@@ -74,9 +77,6 @@ calculate_ionization (restart_stat)
   double freqmin, freqmax;
   long nphot_to_define;
   int iwind;
-#ifdef MPI_ON
-  int ioniz_spec_helpers;
-#endif
 
 
 
@@ -90,12 +90,6 @@ calculate_ionization (restart_stat)
   freqmin = xband.f1[0];
   freqmax = xband.f2[xband.nbands - 1];
 
-#ifdef MPI_ON
-  /* the length of the big arrays to help with the MPI reductions of the spectra
-     the variables for the estimator arrays are set up in the subroutines themselves */
-  ioniz_spec_helpers = 2 * MSPEC * NWAVE;       //we need space for log and lin spectra for MSPEC XNWAVE
-#endif
-
 /* XXXX - THE CALCULATION OF THE IONIZATION OF THE WIND */
 
   geo.ioniz_or_extract = 1;     //SS July 04 - want to compute MC estimators during ionization cycles
@@ -133,6 +127,8 @@ calculate_ionization (restart_stat)
     Log ("!!Python: Beginning cycle %d of %d for defining wind\n", geo.wcycle, geo.wcycles);
     Log_flush ();               /*NH June 13 Added call to flush logfile */
 
+    perf_reset ();
+
     /* Initialize all of the arrays, etc, that need initialization for each cycle
      */
 
@@ -175,7 +171,9 @@ calculate_ionization (restart_stat)
 
     nphot_to_define = (long) NPHOT;
 
+    perf_start (PERF_PHOTON_GEN);
     define_phot (p, freqmin, freqmax, nphot_to_define, 0, iwind, 1);
+    perf_stop (PERF_PHOTON_GEN);
 
     /* Zero the arrays that store the heating of the disk */
 
@@ -223,7 +221,9 @@ calculate_ionization (restart_stat)
       pop_kappa_ff_array ();
 
     /* Transport the photons through the wind */
+    perf_start (PERF_TRANSPORT);
     trans_phot (w, p, 0);
+    perf_stop (PERF_TRANSPORT);
 
     /*Determine how much energy was absorbed in the wind */
     zze = zzz = zz_adiab = 0.0;
@@ -260,10 +260,13 @@ calculate_ionization (restart_stat)
        that has been accummulated on differenet MPI tasks */
 
 #ifdef MPI_ON
+    perf_start (PERF_COMMUNICATE);
 
     communicate_estimators_para ();
 
     communicate_matom_estimators_para ();       // this will return 0 if nlevels_macro == 0
+
+    perf_stop (PERF_COMMUNICATE);
 #endif
 
 
@@ -292,7 +295,9 @@ calculate_ionization (restart_stat)
 
 /* This step shoudl be MPI_parallelised too */
 
+    perf_start (PERF_WIND_UPDATE);
     wind_update (w);
+    perf_stop (PERF_WIND_UPDATE);
 
 
     Log ("Completed ionization cycle %d :  The elapsed TIME was %f\n", geo.wcycle, timer ());
@@ -302,9 +307,11 @@ calculate_ionization (restart_stat)
     /* Do an MPI reduce to get the spectra all gathered to the master thread */
 
 #ifdef MPI_ON
+    perf_start (PERF_COMMUNICATE);
 
-    gather_spectra_para (ioniz_spec_helpers, MSPEC);
+    gather_spectra_para (MSPEC);
 
+    perf_stop (PERF_COMMUNICATE);
 #endif
 
 
@@ -341,7 +348,9 @@ calculate_ionization (restart_stat)
     if (rank_global == 0)
     {
 #endif
+      perf_start (PERF_WINDSAVE);
       wind_save (files.windsave);
+      perf_stop (PERF_WINDSAVE);
       Log_silent ("Saved wind structure in %s after cycle %d\n", files.windsave, geo.wcycle);
 
       /* In a diagnostic mode save the wind file for each cycle (from thread 0) */
@@ -359,7 +368,7 @@ calculate_ionization (restart_stat)
     MPI_Barrier (MPI_COMM_WORLD);
 #endif
 
-
+    perf_report ("ionization", geo.wcycle - 1); // geo.wcycle has already been incremented
 
 
     check_time (files.root);
@@ -375,6 +384,9 @@ calculate_ionization (restart_stat)
   /* SWM - Evaluate wind paths for last iteration */
   if (geo.reverb == REV_WIND || geo.reverb == REV_MATOM)
   {
+#ifdef MPI_ON
+    gather_wind_paths_para (w); // Merge the path histograms from all the threads
+#endif
     wind_paths_evaluate (w);
   }
 
@@ -413,7 +425,6 @@ make_spectra (restart_stat)
   int iwind;
 #ifdef MPI_ON
   char dummy[LINELENGTH];
-  int spec_spec_helpers;
 #endif
 
   /* Next three lines have variables that should be a structure, or possibly we
@@ -432,12 +443,6 @@ make_spectra (restart_stat)
   freqmax = C / (geo.swavemin * 1.e-8);
   freqmin = C / (geo.swavemax * 1.e-8);
 
-#ifdef MPI_ON
-  /* the length of the big arrays to help with the MPI reductions of the spectra
-     the variables for the estimator arrays are set up in the subroutines themselves */
-  spec_spec_helpers = (NWAVE * (MSPEC + geo.nangles));  //We need space for NWAVE wavelengths for nspectra, which will eventually equal nangles + MSPEC
-#endif
-
   /* Perform the initilizations required to handle macro-atoms during the detailed
      calculation of the spectrum.  
 
@@ -506,10 +511,18 @@ make_spectra (restart_stat)
     spectrum_restart_renormalise (geo.nangles);
   }
 
+  /* The wind does not change in the spectral cycles, so the optical depths to the
+     observers can be tabulated once, if this was requested */
+
+  if (geo.extract_tau_table && geo.pcycle < geo.pcycles)
+    extract_tau_table_init (freqmin, freqmax);
+
 
   while (geo.pcycle < geo.pcycles)
   {                             /* This allows you to build up photons in bunches */
 
+    perf_reset ();
+
     xsignal (files.root, "%-20s Starting %d of %d spectral cycle \n", "NOK", geo.pcycle, geo.pcycles);
 
     if (modes.ispy)
@@ -535,7 +548,9 @@ make_spectra (restart_stat)
      */
 
     nphot_to_define = (long) NPHOT *(long) geo.pcycles;
+    perf_start (PERF_PHOTON_GEN);
     define_phot (p, freqmin, freqmax, nphot_to_define, 1, iwind, 0);
+    perf_stop (PERF_PHOTON_GEN);
 
     for (icheck = 0; icheck < NPHOT; icheck++)
     {
@@ -548,7 +563,12 @@ make_spectra (restart_stat)
 
     /* Tranport photons through the wind */
 
+    perf_start (PERF_TRANSPORT);
     trans_phot (w, p, geo.select_extract);
+    perf_stop (PERF_TRANSPORT);
+
+    if (geo.extract_tau_table)
+      extract_tau_table_report ();
 
     if (modes.print_windrad_summary)
       wind_rad_summary (w, files.windrad, "a");
@@ -561,7 +581,9 @@ make_spectra (restart_stat)
 
     /* Do an MPI reduce to get the spectra all gathered to the master thread */
 #ifdef MPI_ON
-    gather_spectra_para (spec_spec_helpers, nspectra);
+    perf_start (PERF_COMMUNICATE);
+    gather_spectra_para (nspectra);
+    perf_stop (PERF_COMMUNICATE);
 #endif
 
 
@@ -588,6 +610,15 @@ make_spectra (restart_stat)
     if (geo.reverb > REV_NONE)
       delay_dump (p, NPHOT, 0); // SWM - Dump delay tracks from this iteration
 
+#ifdef MPI_ON
+    if (geo.reverb_tf)
+    {
+      perf_start (PERF_COMMUNICATE);
+      gather_tf_para ();        // The transfer function is reduced in the same way as the spectra
+      perf_stop (PERF_COMMUNICATE);
+    }
+#endif
+
     /* JM1304: moved geo.pcycle++ after xsignal to record cycles correctly. First cycle is cycle 0. */
 
     xsignal (files.root, "%-20s Finished %3d of %3d spectrum cycles \n", "OK", geo.pcycle, geo.pcycles);
@@ -598,11 +629,16 @@ make_spectra (restart_stat)
     if (rank_global == 0)
     {
 #endif
+      perf_start (PERF_WINDSAVE);
       wind_save (files.windsave);       // This is only needed to update pcycle
+      perf_stop (PERF_WINDSAVE);
       spec_save (files.specsave);
+      if (geo.reverb_tf)
+        reverb_tf_save ();
 #ifdef MPI_ON
     }
 #endif
+    perf_report ("spectrum", geo.pcycle - 1);   // geo.pcycle has already been incremented
     check_time (files.root);
   }
 
@@ -622,8 +658,8 @@ make_spectra (restart_stat)
     delay_dump_finish ();       // Each thread dumps to file
 #ifdef MPI_ON
   MPI_Barrier (MPI_COMM_WORLD); // Once all done
-  if (rank_global == 0 && geo.reverb != REV_NONE)
-    delay_dump_combine (np_mpi_global); // Combine results if necessary
+  if (rank_global == 0 && geo.reverb != REV_NONE && !geo.reverb_tf && geo.reverb_dump == REV_DUMP_TEXT)
+    delay_dump_combine (np_mpi_global); // Combine results if necessary; binary dumps are already in one file
 #endif
 
 
@@ -648,3 +684,235 @@ make_spectra (restart_stat)
   Log ("Completed entire program.  The elapsed TIME was %f\n", timer ());
   return EXIT_SUCCESS;
 }
+
+
+
+/***********************************************************
+                                       University of Southampton
+
+Synopsis:  zeus_server keeps python resident between the steps of
+	a radiation hydrodynamics calculation, exchanging the hydro
+	arrays and the heating and cooling rates through a pair of fifos
+ 
+Arguments:		
+	ndom	the domain which contains the hydro grid
+
+Returns:
+	0 when the hydro code asks the server to stop
+ 
+Description:	
+	In the normal zeus_connect mode python is relaunched for every
+	hydro step, and so has to reread the parameter file, the atomic
+	data, the windsave file and the hydro file each time.  In server
+	mode (the -zs switch) python carries out the first step in the
+	normal way and then calls this routine, which waits for new hydro
+	data on the fifo root.zeus_in and writes the results to the fifo
+	root.zeus_out.  Everything else, including the ionization state,
+	stays in memory.
+
+	Each request consists of 3 ints, nr, ntheta and ncycles, followed
+	by 5*nr*ntheta doubles, which are the rho, temp, v_r, v_theta and
+	v_phi arrays in the order described in hydro_update.  ncycles
+	ionization cycles are then carried out, as in calculate_ionization.
+	A request with ncycles <= 0, or closing the fifo, stops the server.
+
+	Each reply consists of 2 ints, the number of plasma cells ncells
+	and the number of values per cell ZEUS_NVALUES, then 2*ncells ints
+	giving the i, j of each cell in the hydro grid, and then
+	ncells*ZEUS_NVALUES doubles.  The values for each cell are, per
+	unit volume, the photoionization (including auger), Compton, line
+	and free-free heating rates, the Compton, line (including
+	recombination) and free-free cooling rates and the 3 components of
+	the radiative force dmo_dt.  These are the same quantities as are
+	written to py_heatcool.dat.
+
+	All data is binary in the native byte order.
+
+Notes:
+	The hydro code should open root.zeus_in for writing before it
+	opens root.zeus_out for reading, as this is the order in which
+	the server opens them.
+
+	Only the master thread reads and writes the fifos.  The hydro
+	data is broadcast to the other threads, as is the outcome of
+	every read or write, so that if the master thread fails all of
+	the threads stop together.
+
+History:
+
+**************************************************************/
+
+#define ZEUS_NVALUES 10
+
+/* Pass the outcome of an operation carried out by the master thread to
+ * all of the threads, and stop all of them if it failed */
+
+static void
+zeus_server_check (ok)
+     int ok;
+{
+#ifdef MPI_ON
+  MPI_Bcast (&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+  if (!ok)
+  {
+#ifdef MPI_ON
+    MPI_Finalize ();
+#endif
+    exit (0);
+  }
+}
+
+int
+zeus_server (ndom)
+     int ndom;
+{
+  FILE *fin, *fout;
+  char fifo_in[LINELENGTH + 16], fifo_out[LINELENGTH + 16];        /* Room for files.root and the suffix */
+  int head[3], nr, ntheta, ncycles, ncells, nvalues;
+  int nplasma, nwind, i, j, k, nstep, ok;
+  int *ij;
+  double *values, *reply, vol;
+  struct stat fifo_stat;
+
+  fin = fout = NULL;
+  snprintf (fifo_in, sizeof (fifo_in), "%s.zeus_in", files.root);
+  snprintf (fifo_out, sizeof (fifo_out), "%s.zeus_out", files.root);
+
+  ok = 1;
+  if (rank_global == 0)
+  {
+    if ((mkfifo (fifo_in, 0600) != 0 && errno != EEXIST) || (mkfifo (fifo_out, 0600) != 0 && errno != EEXIST))
+    {
+      Error ("zeus_server: Could not create the fifos %s and %s\n", fifo_in, fifo_out);
+      ok = 0;
+    }
+    else if (stat (fifo_in, &fifo_stat) != 0 || !S_ISFIFO (fifo_stat.st_mode)
+             || stat (fifo_out, &fifo_stat) != 0 || !S_ISFIFO (fifo_stat.st_mode))
+    {
+      Error ("zeus_server: %s or %s already exists and is not a fifo\n", fifo_in, fifo_out);
+      ok = 0;
+    }
+    else
+    {
+      Log ("zeus_server: Waiting for hydro data on %s\n", fifo_in);
+
+      if ((fin = fopen (fifo_in, "rb")) == NULL || (fout = fopen (fifo_out, "wb")) == NULL)
+      {
+        Error ("zeus_server: Could not open the fifos %s and %s\n", fifo_in, fifo_out);
+        ok = 0;
+      }
+    }
+  }
+  zeus_server_check (ok);
+
+  nstep = 0;
+
+  while (1)
+  {
+    if (rank_global == 0)
+    {
+      if (fread (head, sizeof (int), 3, fin) != 3)
+        head[2] = 0;            /* The hydro code has gone away, so stop */
+    }
+#ifdef MPI_ON
+    MPI_Bcast (head, 3, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+    nr = head[0];
+    ntheta = head[1];
+    ncycles = head[2];
+
+    if (ncycles <= 0)
+      break;
+
+    nvalues = 5 * nr * ntheta;
+    if (nr <= 0 || ntheta <= 0 || (values = calloc (sizeof (double), nvalues)) == NULL)
+    {
+      Error ("zeus_server: Could not allocate space for a %d x %d hydro grid\n", nr, ntheta);
+      exit (0);
+    }
+
+    ok = 1;
+    if (rank_global == 0 && fread (values, sizeof (double), nvalues, fin) != (size_t) nvalues)
+    {
+      Error ("zeus_server: Hydro data for step %d was incomplete\n", nstep);
+      ok = 0;
+    }
+    zeus_server_check (ok);
+#ifdef MPI_ON
+    MPI_Bcast (values, nvalues, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#endif
+
+    if (hydro_update (nr, ntheta, values) != 0)
+      exit (0);
+    free (values);
+
+    hydro_restart (ndom);
+
+    Log ("zeus_server: Step %d, carrying out %d ionization cycles\n", nstep, ncycles);
+    geo.wcycles = geo.wcycle + ncycles;
+    calculate_ionization (1);
+
+    /* Send back the heating and cooling rates from the last cycle */
+
+    ok = 1;
+    if (rank_global == 0)
+    {
+      ncells = NPLASMA;
+      ij = calloc (sizeof (int), 2 * ncells);
+      reply = calloc (sizeof (double), ZEUS_NVALUES * ncells);
+      if (ij == NULL || reply == NULL)
+      {
+        Error ("zeus_server: Could not allocate space for the reply\n");
+        ok = 0;
+      }
+
+      for (nplasma = 0; ok && nplasma < ncells; nplasma++)
+      {
+        nwind = plasmamain[nplasma].nwind;
+        wind_n_to_ij (ndom, nwind, &i, &j);
+        ij[2 * nplasma] = i - 1;        /* There is a radial ghost zone in python */
+        ij[2 * nplasma + 1] = j;
+        vol = wmain[nwind].vol;
+
+        k = ZEUS_NVALUES * nplasma;
+        reply[k++] = (plasmamain[nplasma].heat_photo + plasmamain[nplasma].heat_auger) / vol;
+        reply[k++] = plasmamain[nplasma].heat_comp / vol;
+        reply[k++] = plasmamain[nplasma].heat_lines / vol;
+        reply[k++] = plasmamain[nplasma].heat_ff / vol;
+        reply[k++] = plasmamain[nplasma].lum_comp / vol;
+        reply[k++] = (plasmamain[nplasma].lum_lines + plasmamain[nplasma].lum_fb + plasmamain[nplasma].lum_dr) / vol;
+        reply[k++] = plasmamain[nplasma].lum_ff / vol;
+        reply[k++] = plasmamain[nplasma].dmo_dt[0] / vol;
+        reply[k++] = plasmamain[nplasma].dmo_dt[1] / vol;
+        reply[k++] = plasmamain[nplasma].dmo_dt[2] / vol;
+      }
+
+      head[0] = ncells;
+      head[1] = ZEUS_NVALUES;
+      if (ok && (fwrite (head, sizeof (int), 2, fout) != 2
+          || fwrite (ij, sizeof (int), 2 * ncells, fout) != (size_t) (2 * ncells)
+          || fwrite (reply, sizeof (double), ZEUS_NVALUES * ncells, fout) != (size_t) (ZEUS_NVALUES * ncells) || fflush (fout) != 0))
+      {
+        Error ("zeus_server: Could not send the results of step %d\n", nstep);
+        ok = 0;
+      }
+
+      free (ij);
+      free (reply);
+    }
+    zeus_server_check (ok);
+
+    nstep++;
+  }
+
+  Log ("zeus_server: Stopping after %d steps\n", nstep);
+
+  if (rank_global == 0)
+  {
+    fclose (fin);
+    fclose (fout);
+  }
+
+  return (0);
+}
@@ -131,6 +131,13 @@ parse_command_line (argc, argv)
         Log ("setting zeus_connect to %i\n", modes.zeus_connect);
         j = i;
       }
+      else if (strcmp (argv[i], "-zs") == 0)
+      {
+        modes.zeus_connect = 1;
+        modes.zeus_server = 1;
+        Log ("setting zeus_connect to %i in server mode\n", modes.zeus_connect);
+        j = i;
+      }
       else if (strcmp (argv[i], "-i") == 0)
       {
         modes.quit_after_inputs = 1;
@@ -355,6 +362,16 @@ get_grid_params (ndom)
       if (zdom[ndom].coord_type != SPHERICAL)
         rddoub ("geo.zlog_scale", &zdom[ndom].zlog_scale);
     }
+
+    if (zdom[ndom].coord_type == CYLIND)
+    {
+      rddoub ("Wind.adaptive_grid_strength(0=off)", &zdom[ndom].adapt_grid);
+      if (zdom[ndom].adapt_grid < 0)
+      {
+        Error ("get_grid_params: Wind.adaptive_grid_strength %g must not be negative\n", zdom[ndom].adapt_grid);
+        exit (0);
+      }
+    }
   }
 
   zdom[ndom].ndim2 = zdom[ndom].ndim * zdom[ndom].mdim;
@@ -1085,6 +1102,34 @@ get_meta_params (void)
       Valid modes are 0=None, 1=Photon, 2=Wind, 3=Macro-atom.\n");
   }
 
+  geo.reverb_dump = REV_DUMP_TEXT;
+  geo.reverb_tf = 0;
+  geo.reverb_tf_nfreq = 100;
+  geo.reverb_tf_ndelay = 100;
+  geo.reverb_tf_delay_max = 1e6;
+  if (geo.reverb != REV_NONE && modes.iadvanced)
+  {                             //Optionally write the delay dump in the binary format, which is much smaller and faster
+    meta_param = 0;
+    rdint ("reverb.dump_format(0=text,1=binary)", &meta_param);
+    if (meta_param == 1)
+      geo.reverb_dump = REV_DUMP_BINARY;
+
+    //Or skip the dump entirely and build up the transfer function as the photons escape
+    rdint ("reverb.transfer_function(0=no,1=yes)", &geo.reverb_tf);
+    if (geo.reverb_tf)
+    {
+      geo.reverb_tf = 1;
+      rdint ("reverb.transfer_function.freq_bins", &geo.reverb_tf_nfreq);
+      rdint ("reverb.transfer_function.delay_bins", &geo.reverb_tf_ndelay);
+      rddoub ("reverb.transfer_function.delay_max(s)", &geo.reverb_tf_delay_max);
+      if (geo.reverb_tf_nfreq < 1 || geo.reverb_tf_ndelay < 1 || geo.reverb_tf_delay_max <= 0.0)
+      {
+        Error ("reverb.transfer_function: Need at least one bin and a positive maximum delay\n");
+        exit (0);
+      }
+    }
+  }
+
   if (geo.reverb == REV_WIND || geo.reverb == REV_MATOM)
   {                             //If this requires further parameters, set defaults
     geo.reverb_lines = 0;
@@ -1447,6 +1492,9 @@ setup_created_files ()
   strcpy (files.new_pf, files.root);
   strcat (files.new_pf, ".out.pf");
 
+  strcpy (files.perf, files.root);
+  strcat (files.perf, ".perf");
+
 
   strcpy (files.windrad, "python");
   strcpy (files.windsave, files.root);
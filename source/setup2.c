@@ -221,6 +221,21 @@ init_geo ()
   geo.wcycles = geo.pcycles = 1;
   geo.wcycle = geo.pcycle = 0;
 
+  geo.incremental_update = 0;   // Update every cell in every cycle
+  geo.incremental_refresh = 5;
+  geo.incremental_nsigma = 3.0;
+
+  geo.adaptive_bands = 0;       // Use the fixed fractions from bands_init
+  geo.adaptive_fraction = 0.5;
+
+  geo.extract_rr_tau = 0.0;     // No Russian roulette in extract
+  geo.extract_tau_table = 0;    // Integrate the path to the observer for every photon
+  geo.extract_tau_nfreq = 100;
+  geo.extract_tau_naz = 8;
+  geo.extract_tau_check = 100;
+
+  geo.nwave = NWAVE;            // The number of frequency bins in the spectra
+
   return (0);
 }
 
@@ -617,9 +632,11 @@ init_advanced_modes ()
   modes.quit_after_inputs = 0;  // testing mode which quits after reading in inputs
   modes.fixed_temp = 0;         // do not attempt to change temperature - used for testing
   modes.zeus_connect = 0;       // connect with zeus
+  modes.zeus_server = 0;        // stay resident and exchange data with zeus through fifos
 
   //note write_atomicdata  is defined in atomic.h, rather than the modes structure 
   write_atomicdata = 0;         // print out summary of atomic data 
+  atomic_cache = ATOMIC_CACHE_READ | ATOMIC_CACHE_WRITE; // read and write the binary cache of the atomic data
 
 
   modes.keep_photoabs = 1;      // keep photoabsorption in final spectrum
@@ -765,6 +782,36 @@ init_observers ()
         }
       }
     }
+
+    /* Russian roulette in extract_one, see there. 0 switches it off */
+    rddoub ("Extract.russian_roulette_tau(0=off)", &geo.extract_rr_tau);
+    if (geo.extract_rr_tau < 0.0 || geo.extract_rr_tau >= TAU_MAX)
+    {
+      Error ("init_observers: Extract.russian_roulette_tau %g must lie between 0 and %g\n", geo.extract_rr_tau, TAU_MAX);
+      exit (0);
+    }
+
+    /* Tabulated optical depths to the observers, see extract_tau_table_init */
+    rdint ("Extract.tau_table(0=no,1=yes)", &geo.extract_tau_table);
+    if (geo.extract_tau_table)
+    {
+      rdint ("Extract.tau_table_nfreq", &geo.extract_tau_nfreq);
+      rdint ("Extract.tau_table_nazimuth", &geo.extract_tau_naz);
+      rdint ("Extract.tau_table_check_every(0=never)", &geo.extract_tau_check);
+      if (geo.extract_tau_nfreq < 2 || geo.extract_tau_naz < 1 || geo.extract_tau_check < 0)
+      {
+        Error ("init_observers: Extract.tau_table needs at least 2 frequencies and 1 azimuth\n");
+        exit (0);
+      }
+    }
+
+    /* The resolution of the spectra.  Only the end bins, which collect photons outside the range, are not written out */
+    rdint ("Spectrum.nwave", &geo.nwave);
+    if (geo.nwave < 3)
+    {
+      Error ("init_observers: Spectrum.nwave %d must be at least 3\n", geo.nwave);
+      exit (0);
+    }
   }
 
   /* Select the units of the output spectra.  This is always needed */
@@ -935,6 +982,22 @@ init_ionization ()
   }
 
 
+  /* The incremental update only re-solves cells whose radiation field has changed significantly.
+     It is an advanced option, since it is only worthwhile for large grids late in a run */
+
+  if (modes.iadvanced)
+  {
+    rdint ("Incremental.wind_update(0=no,1=yes)", &geo.incremental_update);
+    if (geo.incremental_update)
+    {
+      rdint ("Incremental.full_update_every_n_cycles", &geo.incremental_refresh);
+      rddoub ("Incremental.threshold_in_sigma", &geo.incremental_nsigma);
+      if (geo.incremental_refresh < 1)
+        geo.incremental_refresh = 1;
+    }
+  }
+
+
   /* 57h -- Next line prevents bf calculation of macro_estimaters when no macro atoms are present.   */
 
   if (nlevels_macro == 0)
@@ -95,15 +95,19 @@ spectrum_init (f1, f2, nangle, angle, phase, scat_select, top_bot_select, select
      double rho_select[], z_select[], az_select[], r_select[];
 {
   int i, n;
-  int nspec;
+  int nspec, nwave;
   double freqmin, freqmax, dfreq;
   double lfreqmin, lfreqmax, ldfreq;    /* NSH 1302 Min, max and delta for the log spectrum */
   double x1, x2;
   char dummy[20];
 
+  nwave = geo.nwave;
+  if (nwave < 3)
+    nwave = NWAVE;
+
   freqmin = f1;
   freqmax = f2;
-  dfreq = (freqmax - freqmin) / NWAVE;
+  dfreq = (freqmax - freqmin) / nwave;
 
   nspec = nangle + MSPEC;
 
@@ -111,19 +115,12 @@ spectrum_init (f1, f2, nangle, angle, phase, scat_select, top_bot_select, select
 
   lfreqmin = log10 (freqmin);
   lfreqmax = log10 (freqmax);
-  ldfreq = (lfreqmax - lfreqmin) / NWAVE;
+  ldfreq = (lfreqmax - lfreqmin) / nwave;
 
   /* Create the spectrum arrays the first time routine is called */
   if (i_spec_start == 0)
   {
-    xxspec = calloc (sizeof (spectrum_dummy), nspec);
-    if (xxspec == NULL)
-    {
-      Error ("spectrum_init: Could not allocate memory for %d spectra with %d wavelengths\n", nspec, NWAVE);
-      exit (0);
-    }
-
-    nspectra = nspec;           /* Note that nspectra is a global variable */
+    spectrum_alloc (nspec, nwave);
 
     i_spec_start = 1;           /* This is to prevent reallocation of the same arrays on multiple calls to spectrum_init */
   }
@@ -148,10 +145,12 @@ spectrum_init (f1, f2, nangle, angle, phase, scat_select, top_bot_select, select
     xxspec[n].ldfreq = ldfreq;
     for (i = 0; i < NSTAT; i++)
       xxspec[n].nphot[i] = 0;
-    for (i = 0; i < NWAVE; i++)
+    for (i = 0; i < xxspec[n].nwave; i++)
     {
       xxspec[n].f[i] = 0;
       xxspec[n].lf[i] = 0;      /* NSH 1302 zero the logarithmic spectra */
+      xxspec[n].f_wind[i] = 0;
+      xxspec[n].lf_wind[i] = 0;
     }
   }
 
@@ -347,10 +346,12 @@ spectrum_create (p, f1, f2, nangle, select_extract)
   double nlow, nhigh;
   int k_orig, k1_orig;
   int iwind;                    // Variable defining whether this is a wind photon
+  int nwave;
 
+  nwave = xxspec[0].nwave;
   freqmin = f1;
   freqmax = f2;
-  dfreq = (freqmax - freqmin) / NWAVE;
+  dfreq = (freqmax - freqmin) / nwave;
   nspec = nangle + MSPEC;
   nlow = 0.0;                   // variable to storte the number of photons that have frequencies which are too low
   nhigh = 0.0;                  // variable to storte the number of photons that have frequencies which are too high
@@ -360,7 +361,7 @@ spectrum_create (p, f1, f2, nangle, select_extract)
 
   lfreqmin = log10 (freqmin);
   lfreqmax = log10 (freqmax);
-  ldfreq = (lfreqmax - lfreqmin) / NWAVE;
+  ldfreq = (lfreqmax - lfreqmin) / nwave;
 
 
   for (nphot = 0; nphot < NPHOT; nphot++)
@@ -386,25 +387,25 @@ spectrum_create (p, f1, f2, nangle, select_extract)
     }
 
     /* find out where we are in log space */
-    k1 = (log10 (p[nphot].freq) - log10 (freqmin)) / ldfreq;
+    k1 = (log10 (p[nphot].freq) - lfreqmin) / ldfreq;
     if (k1 < 0)
     {
       k1 = 0;
     }
-    if (k1 > NWAVE - 1)
+    if (k1 > nwave - 1)
     {
-      k1 = NWAVE - 1;
+      k1 = nwave - 1;
     }
 
     /* also need to work out where we are for photon's original wavelength */
-    k1_orig = (log10 (p[nphot].freq_orig) - log10 (freqmin)) / ldfreq;
+    k1_orig = (log10 (p[nphot].freq_orig) - lfreqmin) / ldfreq;
     if (k1_orig < 0)
     {
       k1_orig = 0;
     }
-    if (k1_orig > NWAVE - 1)
+    if (k1_orig > nwave - 1)
     {
-      k1_orig = NWAVE - 1;
+      k1_orig = nwave - 1;
     }
 
 
@@ -416,11 +417,11 @@ spectrum_create (p, f1, f2, nangle, select_extract)
         nlow = nlow + 1;
       k = 0;
     }
-    else if (k > NWAVE - 1)
+    else if (k > nwave - 1)
     {
       if (((1. - freqmax / p[nphot].freq) > delta) && (geo.rt_mode != 2))
         nhigh = nhigh + 1;
-      k = NWAVE - 1;
+      k = nwave - 1;
     }
 
     /* also need to work out where we are for photon's original wavelength */
@@ -431,11 +432,11 @@ spectrum_create (p, f1, f2, nangle, select_extract)
         nlow = nlow + 1;
       k_orig = 0;
     }
-    else if (k_orig > NWAVE - 1)
+    else if (k_orig > nwave - 1)
     {
       if (((1. - freqmax / p[nphot].freq_orig) > delta) && (geo.rt_mode != 2))
         nhigh = nhigh + 1;
-      k_orig = NWAVE - 1;
+      k_orig = nwave - 1;
     }
 
 
@@ -751,8 +752,8 @@ spectrum_summary (filename, mode, nspecmin, nspecmax, select_spectype, renorm, l
   if (loglin == 0)              /* Then were are writing out the linear version of the spectra */
   {
     freqmin = xxspec[nspecmin].freqmin;
-    dfreq = (xxspec[nspecmin].freqmax - freqmin) / NWAVE;
-    for (i = 1; i < NWAVE - 1; i++)
+    dfreq = (xxspec[nspecmin].freqmax - freqmin) / xxspec[nspecmin].nwave;
+    for (i = 1; i < xxspec[nspecmin].nwave - 1; i++)
     {
       freq = freqmin + i * dfreq;
       fprintf (fptr, "%-8e %.3f ", freq, C * 1e8 / freq);
@@ -789,9 +790,9 @@ spectrum_summary (filename, mode, nspecmin, nspecmax, select_spectype, renorm, l
     lfreqmin = log10 (xxspec[nspecmin].freqmin);
     freq1 = lfreqmin;
     lfreqmax = log10 (xxspec[nspecmin].freqmax);
-    ldfreq = (lfreqmax - lfreqmin) / NWAVE;
+    ldfreq = (lfreqmax - lfreqmin) / xxspec[nspecmin].nwave;
 
-    for (i = 1; i < NWAVE - 1; i++)
+    for (i = 1; i < xxspec[nspecmin].nwave - 1; i++)
     {
       freq = pow (10., (lfreqmin + i * ldfreq));
       dfreq = freq - freq1;
@@ -876,7 +877,7 @@ spectrum_restart_renormalise (nangle)
   /* loop over each spectrum column and each wavelength bin */
   for (n = MSPEC; n < nspec; n++)
   {
-    for (m = 0; m < NWAVE; m++)
+    for (m = 0; m < xxspec[n].nwave; m++)
     {
       xxspec[n].f[m] *= renorm_factor;
       xxspec[n].lf[m] *= renorm_factor;
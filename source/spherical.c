@@ -380,7 +380,6 @@ spherical_where_in_grid (ndom, x)
 {
   int n;
   double r;
-  double f;
   int ndim;
 
 
@@ -398,7 +397,7 @@ spherical_where_in_grid (ndom, x)
     return (-1);                /*x is inside grid */
   }
 
-  fraction (r, zdom[ndom].wind_x, ndim, &n, &f, 0);
+  n = zdom[ndom].wig_i = fraction_guess (r, zdom[ndom].wind_x, ndim, zdom[ndom].wig_i);
 
   // n is the position with this domain, so zdom[ndom].nstart is added 
   // get to wmain
@@ -16,12 +16,26 @@ int index_collisions(void);
 void indexx(int n, float arrin[], int indx[]);
 int limit_lines(double freqmin, double freqmax);
 int check_xsections(void);
+int atomic_hash_init(void);
+int atomic_hash_free(void);
+int atomic_hash(int i1, int i2, int i3, int i4, int nbuckets);
+int config_hash_add(int n);
+int config_hash_find(int z, int istate, int ilv, int n);
+int line_hash_add(int n);
+int line_hash_find(int z, int istate, int levl, int levu, int n);
+unsigned long long atomic_cache_key(char masterfile[]);
+unsigned long long atomic_cache_hash_file(char filename[], unsigned long long key);
+int atomic_cache_blocks(Atomic_cache_headPtr head, void *ptr[], size_t size[], int count[]);
+int atomic_cache_read(char masterfile[], unsigned long long key);
+int atomic_cache_write(char masterfile[], unsigned long long key);
 /* python.c */
 int main(int argc, char *argv[]);
 /* photon2d.c */
 int translate(WindPtr w, PhotPtr pp, double tau_scat, double *tau, int *nres);
 int translate_in_space(PhotPtr pp);
 double ds_to_wind(PhotPtr pp);
+int ds_to_wind_init(void);
+double ds_to_sphere_sq(double r2, double b, double xx);
 int translate_in_wind(WindPtr w, PhotPtr p, double tau_scat, double *tau, int *nres);
 int walls(PhotPtr p, PhotPtr pold);
 /* photon_gen.c */
@@ -52,6 +66,7 @@ int spectrum_restart_renormalise(int nangle);
 int define_wind(void);
 int where_in_grid(int ndom, double x[]);
 int vwind_xyz(int ndom, PhotPtr p, double v[]);
+int vwind_coef_init(void);
 int wind_div_v(WindPtr w);
 double rho(WindPtr w, double x[]);
 int mdot_wind(WindPtr w, double z, double rmax);
@@ -132,15 +147,24 @@ int wind_update(WindPtr (w));
 int wind_rad_init(void);
 int wind_rad_summary(WindPtr w, char filename[], char mode[]);
 int wind_ip(void);
+int incremental_skip(PlasmaPtr xplasma);
+int incremental_store(PlasmaPtr xplasma);
 /* windsave.c */
 int wind_save(char filename[]);
 int wind_read(char filename[]);
+int wind_read_array(void *x, size_t size, int n, int want, FILE *fptr);
+int wind_read_select(char filename[], int parts);
 int wind_complete(WindPtr w);
+int spectrum_alloc(int nspec, int nwave);
 int spec_save(char filename[]);
 int spec_read(char filename[]);
 /* extract.c */
 int extract(WindPtr w, PhotPtr p, int itype);
 int extract_one(WindPtr w, PhotPtr pp, int itype, int nspec);
+int extract_tau_table_init(double freqmin, double freqmax);
+int extract_tau_path(WindPtr w, PhotPtr pp, double *tau);
+int extract_tau_lookup(PhotPtr pp, int nspec, double *tau);
+int extract_tau_table_report(void);
 /* pdf.c */
 int pdf_gen_from_func(PdfPtr pdf, double (*func)(double), double xmin, double xmax, int njumps, double jump[]);
 double gen_array_from_func(double (*func)(double), double xmin, double xmax, int pdfsteps);
@@ -151,6 +175,8 @@ double pdf_get_rand_limit(PdfPtr pdf);
 int pdf_to_file(PdfPtr pdf, char filename[]);
 int pdf_check(PdfPtr pdf);
 int recalc_pdf_from_cdf(PdfPtr pdf);
+int alias_gen(AliasPtr alias, double weight[], int n);
+int alias_get_rand(AliasPtr alias);
 /* roche.c */
 int binary_basics(void);
 double ds_to_roche_2(PhotPtr p);
@@ -186,6 +212,7 @@ int rtheta_hydro_volumes(int ndom, WindPtr w);
 int hydro_frac(double coord, double coord_array[], int imax, int *cell1, int *cell2, double *frac);
 double hydro_interp_value(double array[], int im, int ii, int jm, int jj, double f1, double f2);
 int hydro_restart(int ndom);
+int hydro_update(int nr, int ntheta, double values[]);
 /* corona.c */
 int get_corona_params(int ndom);
 double corona_velocity(int ndom, double x[], double v[]);
@@ -204,6 +231,8 @@ double gdisk(double mass, double mdot, double rmin);
 double geff(double g0, double x);
 double vdisk(double x[], double v[]);
 double zdisk(double r);
+double zdisk_slope(double r);
+double disk_plane_r(struct photon *p, double height, double *s);
 double ds_to_disk(struct photon *p, int miss_return);
 void disk_deriv(double s, double *value, double *derivative);
 /* lines.c */
@@ -222,6 +251,8 @@ int line_heat(PlasmaPtr xplasma, PhotPtr pp, int nres);
 double upsilon(int n_coll, double u0);
 /* continuum.c */
 double one_continuum(int spectype, double t, double g, double freqmin, double freqmax);
+int disk_pdf_init(int spectype, double freqmin, double freqmax);
+double disk_continuum(int nring, double freqmin, double freqmax);
 double emittance_continuum(int spectype, double freqmin, double freqmax, double t, double g);
 /* emission.c */
 double wind_luminosity(double f1, double f2);
@@ -266,6 +297,7 @@ int convergence(PlasmaPtr xplasma);
 int check_convergence(void);
 int one_shot(PlasmaPtr xplasma, int mode);
 double calc_te(PlasmaPtr xplasma, double tmin, double tmax);
+double te_eval(double t, double tmin, double tmax, int *have_tmin, double *z_tmin, int *have_tmax, double *z_tmax);
 double zero_emit(double t);
 /* ispy.c */
 int ispy_init(char filename[], int icycle);
@@ -286,8 +318,10 @@ int make_pdf_randwind(double tau);
 int randwind_thermal_trapping(PhotPtr p, int *nnscat);
 /* util.c */
 int fraction(double value, double array[], int npts, int *ival, double *f, int mode);
+int fraction_guess(double value, double array[], int npts, int iguess);
 int linterp(double x, double xarray[], double yarray[], int xdim, double *y, int mode);
 int coord_fraction(int ndom, int ichoice, double x[], int ii[], double frac[], int *nelem);
+int coord_locate(int ndom, int ichoice, double x[], int *ix, double *dr, int *iz, double *dz);
 int where_in_2dcell(int ichoice, double x[], int n, double *fx, double *fz);
 int wind_n_to_ij(int ndom, int n, int *i, int *j);
 int wind_ij_to_n(int ndom, int i, int j, int *n);
@@ -300,6 +334,7 @@ int wind_update_after_detailed_balance(PlasmaPtr xplasma, int nelem, double newd
 /* bands.c */
 int bands_init(int imode, struct xbands *band);
 int freqs_init(double freqmin, double freqmax);
+int bands_adapt(struct xbands *band);
 /* time.c */
 double timer(void);
 int get_time(char curtime[]);
@@ -350,6 +385,9 @@ double ds_to_pillbox(PhotPtr pp, double rmin, double rmax, double height);
 /* cylindrical.c */
 double cylind_ds_in_cell(PhotPtr p);
 int cylind_make_grid(int ndom, WindPtr w);
+int cylind_adapt_grid(int ndom, WindPtr w);
+int cylind_adapt_edges(int ndom, int idir, double old[], int n, double other[], int nother, double edge[]);
+double cylind_adapt_min(double edge[], int nmin, int nmax);
 int cylind_wind_complete(int ndom, WindPtr w);
 int cylind_volumes(int ndom, WindPtr w);
 int cylind_where_in_grid(int ndom, double x[]);
@@ -444,6 +482,7 @@ double exp_stddev(double exp_temp, double numin, double numax);
 int variable_temperature(PlasmaPtr xplasma, int mode);
 double pi_correct(double xtemp, int nion, PlasmaPtr xplasma, int mode);
 double temp_func(double solv_temp);
+double temp_func_solve(double tguess, double tmin, double tmax, double tol);
 /* matom_diag.c */
 int matom_emiss_report(void);
 /* direct_ion.c */
@@ -465,7 +504,11 @@ int populate_ion_rate_matrix(PlasmaPtr xplasma, double rate_matrix[nions][nions]
 int solve_matrix(double *a_data, double *b_data, int nrows, double *x, int nplasma);
 /* para_update.c */
 int communicate_estimators_para(void);
-int gather_spectra_para(int nspec_helper, int nspecs);
+int gather_spectra_para(int nspecs);
+int gather_tf_para(void);
+int gather_wind_paths_para(WindPtr wind);
+int pack_wind_paths_para(WindPtr wind, int nstart, int nstop, int ibuf[], double dbuf[]);
+int unpack_wind_paths_para(WindPtr wind, int nentries, int ibuf[], double dbuf[], double scale);
 int communicate_matom_estimators_para(void);
 /* setup.c */
 int parse_command_line(int argc, char *argv[]);
@@ -485,6 +528,7 @@ int get_standard_care_factors(void);
 /* photo_gen_matom.c */
 double get_kpkt_f(void);
 double get_matom_f(int mode);
+int matom_alias_init(void);
 int photo_gen_kpkt(PhotPtr p, double weight, int photstart, int nphot);
 int photo_gen_matom(PhotPtr p, double weight, int photstart, int nphot);
 /* macro_gov.c */
@@ -497,10 +541,21 @@ int delay_dump_finish(void);
 int delay_dump_combine(int i_ranks);
 int delay_dump(PhotPtr p, int np, int iExtracted);
 int delay_dump_single(PhotPtr pp, int extract_phot);
+int delay_dump_binary_open(int restart_stat);
+int delay_dump_row(PhotPtr pp, double delay, int nspec, int extracted);
+int delay_dump_flush(void);
+int delay_dump_binary_close(void);
+int reverb_tf_init(int restart_stat);
+int reverb_tf_add(int nspec, double freq, double delay, double w);
+int reverb_tf_save(void);
 /* paths.c */
 Wind_Paths_Ptr wind_paths_constructor(WindPtr wind);
+Wind_Paths_Ptr line_paths_get(WindPtr wind, int i);
+int wind_paths_add_bin(Wind_Paths_Ptr paths, int i_bin, double r_flux, int i_num);
+double wind_paths_flux(Wind_Paths_Ptr paths, int i_bin);
 int reverb_init(WindPtr wind);
 int wind_paths_init(WindPtr wind);
+int path_bin_index(double r_path);
 int line_paths_add_phot(WindPtr wind, PhotPtr pp, int *nres);
 int wind_paths_add_phot(WindPtr wind, PhotPtr pp);
 int simple_paths_gen_phot(PhotPtr pp);
@@ -529,6 +584,7 @@ int init_ionization(void);
 /* run.c */
 int calculate_ionization(int restart_stat);
 int make_spectra(int restart_stat);
+int zeus_server(int ndom);
 /* brem.c */
 double emittance_brem(double freqmin, double freqmax, double lum, double t);
 double integ_brem(double freq);
@@ -539,6 +595,12 @@ int search_light_init(void);
 int photo_gen_search_light(PhotPtr p, double r, double alpha, double weight, double f1, double f2, int spectype, int istart, int nphot);
 /* synonyms.c */
 int check_synonyms(char new_question[], char old_question[]);
+/* perf.c */
+int perf_init(int restart_stat);
+int perf_reset(void);
+int perf_start(int itimer);
+int perf_stop(int itimer);
+int perf_report(char *cycle_type, int cycle);
 /* py_wind_sub.c */
 int zoom(int direction);
 int overview(WindPtr w, char rootname[]);
@@ -58,6 +58,11 @@ FILE *pltptr;
 int plinit = 0;
 long n_lost_to_dfudge = 0;
 
+/* Timing every call to extract would cost two calls to timer each time, so only the extractions of
+   the first photon in each batch of PERF_EXTRACT_BATCH are timed, and the total is scaled up at the
+   end of trans_phot */
+int perf_extract_timed = 0;
+
 int trans_phot (WindPtr w, PhotPtr p, int iextract      /* 0 means do not extract along specific angles; nonzero implies to extract */
   )
 {
@@ -67,6 +72,8 @@ int trans_phot (WindPtr w, PhotPtr p, int iextract      /* 0 means do not extrac
   int disk_illum;               /* this is a variable used to store geo.disk_illum during exxtract */
   int nerr;
   double p_norm, tau_norm;
+  double extract_time;
+  int nextract_timed;
 
 
 
@@ -89,8 +96,13 @@ int trans_phot (WindPtr w, PhotPtr p, int iextract      /* 0 means do not extrac
 
   Log ("\n");
 
+  extract_time = perf_time[PERF_EXTRACT];
+  nextract_timed = 0;
+
   for (nphot = 0; nphot < NPHOT; nphot++)
   {
+    if ((perf_extract_timed = (iextract && nphot % PERF_EXTRACT_BATCH == 0)))
+      nextract_timed++;
 
     // This is just a watchdog method to tell the user the program is still running
     // 130306 - ksl since we don't really care what the frequencies are any more
@@ -196,7 +208,11 @@ int trans_phot (WindPtr w, PhotPtr p, int iextract      /* 0 means do not extrac
       {
         Error ("trans_phot: sane_check photon %d has weight %e before extract\n", nphot, pextract.w);
       }
+      if (perf_extract_timed)
+        perf_start (PERF_EXTRACT);
       extract (w, &pextract, pextract.origin);
+      if (perf_extract_timed)
+        perf_stop (PERF_EXTRACT);
 
 
       // Restore the correct disk illumination
@@ -215,6 +231,11 @@ int trans_phot (WindPtr w, PhotPtr p, int iextract      /* 0 means do not extrac
   // 130624 ksl Line added to complete watchdog timer,
   Log ("\n\n");
 
+  /* Scale the time spent extracting the sampled photons up to all of them */
+  if (nextract_timed > 0)
+    perf_time[PERF_EXTRACT] = extract_time + (perf_time[PERF_EXTRACT] - extract_time) * NPHOT / nextract_timed;
+  perf_extract_timed = 0;
+
   /* sometimes photons scatter near the edge of the wind and get pushed out by DFUDGE. We record these */
   if (n_lost_to_dfudge > 0)
     Error ("%ld photons were lost due to DFUDGE (=%8.4e) pushing them outside of the wind after scatter\n", n_lost_to_dfudge, DFUDGE);
@@ -423,6 +444,7 @@ trans_phot_single (WindPtr w, PhotPtr p, int iextract)
         Error ("trans_phot: Bad return from scatter %d at point 2", nerr);
       }
       pp.nscat++;
+      perf_count[PERF_SCATTERS]++;
       /* 74a_ksl - Check added to search for error in weights */
 
       if (sane_check (pp.w))
@@ -531,7 +553,11 @@ trans_phot_single (WindPtr w, PhotPtr p, int iextract)
         {
           Error ("trans_phot: sane_check photon %d has weight %e before extract\n", p->np, pextract.w);
         }
+        if (perf_extract_timed)
+          perf_start (PERF_EXTRACT);
         extract (w, &pextract, PTYPE_WIND);     // Treat as wind photon for purpose of extraction
+        if (perf_extract_timed)
+          perf_stop (PERF_EXTRACT);
       }
 
 
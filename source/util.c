@@ -165,6 +165,39 @@ to reflect the behavior of the search routine in where_in_grid. */
 
 
 
+/* 
+fraction_guess returns the same index as fraction (in mode 0), but checks first
+whether value lies in the interval iguess or one of its neighbours before 
+falling back to a binary search.  Photons usually move from a cell to one of its 
+neighbours, so for locating them in the grid this is normally O(1).  Unlike 
+fraction, it does not calculate the fractional position in the interval.
+*/
+
+int
+fraction_guess (value, array, npts, iguess)
+     double array[];            // The array in we want to search
+     int npts, iguess;          // iguess is the interval to try first
+     double value;              // The value we want to index
+{
+  int i, k, ival;
+  double f;
+
+  for (k = 0; k < 3; k++)
+  {
+    i = (k == 0) ? iguess : (k == 1) ? iguess + 1 : iguess - 1;
+    if (i < 0 || i > npts - 2)
+      continue;
+    if ((i == 0 || value > array[i]) && (i == npts - 2 || value <= array[i + 1]))
+      return (i);
+  }
+
+  fraction (value, array, npts, &ival, &f, 0);
+  return (ival);
+}
+
+
+
+
 /* 
 Given a number x, and an array of x's in xarray, and functional
 values y = f(x) in yarray and the dimension of xarray and yarray,
@@ -306,11 +339,9 @@ coord_fraction (ndom, ichoice, x, ii, frac, nelem)
      double frac[];
      int *nelem;
 {
-  double r, z;
-  double *xx, *zz;
   int ix, iz;
   double dr, dz;
-  int n;
+  int n, nstart;
 
 
   /* Jump to special routine if CYLVAR coords */
@@ -328,6 +359,99 @@ coord_fraction (ndom, ichoice, x, ii, frac, nelem)
 
   }
 
+  n = coord_locate (ndom, ichoice, x, &ix, &dr, &iz, &dz);
+
+  /* The elements are in wmain, so the start of the domain must be added */
+  nstart = zdom[ndom].nstart;
+
+  if (zdom[ndom].coord_type == SPHERICAL)
+  {                             /* We are dealing with a 1d system */
+    ii[0] = nstart + ix;
+    frac[0] = (1. - dr);
+    ii[1] = nstart + ix + 1;
+    frac[1] = dr;
+    *nelem = 2;
+    if (sane_check (dr))
+    {
+      Error ("coord_frac:sane_check dr=%f for spherical coords. \n", dr);
+    }
+  }
+  else
+  {                             /* We are dealing with a 2d system */
+    ii[0] = nstart + ix * zdom[ndom].mdim + iz;
+    frac[0] = (1. - dz) * (1. - dr);
+
+    ii[1] = nstart + (ix + 1) * zdom[ndom].mdim + iz;
+    frac[1] = (1. - dz) * dr;
+
+    ii[2] = nstart + ix * zdom[ndom].mdim + iz + 1;
+    frac[2] = (dz) * (1. - dr);
+
+    ii[3] = nstart + (ix + 1) * zdom[ndom].mdim + iz + 1;
+    frac[3] = (dz) * (dr);
+    *nelem = 4;
+
+    if (sane_check (dr) || sane_check (dz))
+    {
+      Error ("coord_frac:sane_check dr=%f dz=%f for 2d coords\n", dr, dz);
+    }
+  }
+
+  return (n);
+
+}
+
+
+
+/***********************************************************
+           Space Telescope Science Institute
+
+Synopsis:  coord_locate finds the grid element, and the fractional position 
+	within it, of a position in a cylindrical, rtheta or spherical grid
+
+Arguments:
+	ndom	the domain
+	ichoice=0 --> interpolate on vertices
+	ichoice=1 --> interpolate on centers
+	x	the position
+
+Returns:
+	ix, iz	the element in the two directions (iz is 0 for 
+		spherical grids)
+	dr, dz	the fractional position between element i and i+1, 
+		which is 0 or 1 if the position is off the edge of the grid
+
+	The function returns -2 if the position is beyond the grid, -1 if
+	it is inside the grid, and 1 otherwise, as coord_fraction does.
+
+Description:
+	The elements are those that fraction would have returned, but the 
+	search starts from the last element found for this domain and choice 
+	of grid, as photons usually move from one cell to a neighbouring one.
+
+Notes:
+	This is the part of coord_fraction which does not depend on how the
+	result is to be used, so that vwind_xyz can use it as well.
+
+**************************************************************/
+
+int
+coord_locate (ndom, ichoice, x, ix, dr, iz, dz)
+     int ndom;
+     int ichoice;
+     double x[];
+     int *ix, *iz;
+     double *dr, *dz;
+{
+  double r, z;
+  double *xx, *zz;
+  int i, ndim, mdim;
+  DomainPtr one_dom;
+
+  one_dom = &zdom[ndom];
+  ndim = one_dom->ndim;
+  mdim = one_dom->mdim;
+
   /* Assign pointers to the xx and zz depending on whether
    * one wants to interpolate on vertex points (0) or 
    * midpoints (1)
@@ -335,79 +459,67 @@ coord_fraction (ndom, ichoice, x, ii, frac, nelem)
 
   if (ichoice == 0)
   {
-    xx = zdom[ndom].wind_x;
-    zz = zdom[ndom].wind_z;
+    xx = one_dom->wind_x;
+    zz = one_dom->wind_z;
   }
   else
   {
-    xx = zdom[ndom].wind_midx;
-    zz = zdom[ndom].wind_midz;
+    xx = one_dom->wind_midx;
+    zz = one_dom->wind_midz;
   }
 
   /* Now convert x to the appropriate coordinate system */
-  if (zdom[ndom].coord_type == CYLIND)
+  if (one_dom->coord_type == CYLIND)
   {
     r = sqrt (x[0] * x[0] + x[1] * x[1]);
     z = fabs (x[2]);
   }
-  else if (zdom[ndom].coord_type == RTHETA)
+  else if (one_dom->coord_type == RTHETA)
   {
     r = length (x);
     z = acos (fabs (x[2]) / r) * RADIAN;
   }
-  else if (zdom[ndom].coord_type == SPHERICAL)
+  else if (one_dom->coord_type == SPHERICAL)
   {
     r = length (x);
     z = 0;                      // To avoid -O3 warning
   }
   else
   {
-    Error ("coord_fraction: Unknown coordinate type %d for doman\n", zdom[ndom].coord_type, ndom);
+    Error ("coord_locate: Unknown coordinate type %d for doman %d\n", one_dom->coord_type, ndom);
     exit (0);
   }
 
-  if (zdom[ndom].coord_type == SPHERICAL)
-  {                             /* We are dealing with a 1d system */
-    fraction (r, xx, zdom[ndom].ndim, &ix, &dr, 0);     //linear space
-    ii[0] = ix;
-    frac[0] = (1. - dr);
-    ii[1] = ix + 1;
-    frac[1] = dr;
-    *nelem = 2;
-    if (sane_check (dr))
-    {
-      Error ("coord_frac:sane_check dr=%f for spherical coords. \n", dr);
-    }
-  }
+  i = *ix = one_dom->cf_i[ichoice] = fraction_guess (r, xx, ndim, one_dom->cf_i[ichoice]);
+  if (r < xx[0])
+    *dr = 0.0;
+  else if (r > xx[ndim - 1])
+    *dr = 1.0;
   else
-  {                             /* We are dealing with a 2d system */
-    fraction (r, xx, zdom[ndom].ndim, &ix, &dr, 0);
-    fraction (z, zz, zdom[ndom].mdim, &iz, &dz, 0);
-
-    ii[0] = ix * zdom[ndom].mdim + iz;
-    frac[0] = (1. - dz) * (1. - dr);
-
-    ii[1] = (ix + 1) * zdom[ndom].mdim + iz;
-    frac[1] = (1. - dz) * dr;
-
-    ii[2] = ix * zdom[ndom].mdim + iz + 1;
-    frac[2] = (dz) * (1. - dr);
+    *dr = (r - xx[i]) / (xx[i + 1] - xx[i]);
 
-    ii[3] = (ix + 1) * zdom[ndom].mdim + iz + 1;
-    frac[3] = (dz) * (dr);
-    *nelem = 4;
-
-    if (sane_check (dr) || sane_check (dz))
-    {
-      Error ("coord_frac:sane_check dr=%f dz=%f for 2d coords\n", dr, dz);
-    }
+  if (one_dom->coord_type == SPHERICAL)
+  {
+    *iz = 0;
+    *dz = 0.0;
+  }
+  else
+  {
+    i = *iz = one_dom->cf_j[ichoice] = fraction_guess (z, zz, mdim, one_dom->cf_j[ichoice]);
+    if (z < zz[0])
+      *dz = 0.0;
+    else if (z > zz[mdim - 1])
+      *dz = 1.0;
+    else
+      *dz = (z - zz[i]) / (zz[i + 1] - zz[i]);
   }
+
   /* At this point i,j are just outside the x position */
   /* Check to see if x is outside the region of the calculation */
   /* Note that this is a very incoplethe check in the sneste that 
    * the posision could be out of the grid in other directions */
 
-  if (r > xx[zdom[ndom].ndim - 1])
+  if (r > xx[ndim - 1])
   {
     return (-2);                /* x is outside grid */
   }
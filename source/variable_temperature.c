@@ -103,6 +103,7 @@ variable_temperature (xplasma, mode)
   double pi_fudge, recomb_fudge, tot_fudge;     /*Two of the correction factors for photoionization rate, and recombination rate */
   double gs_fudge[NIONS];       /*It can be expensive to calculate this, and it only depends on t_e - which is fixed for a run. So 
                                    //                 calculate it once, and store it in a temporary array */
+  double xtemp_guess[NIONS];    /* The pair temperature from the last pass through the ne loop, used as a starting guess */
 
   nh = xplasma->rho * rho2nh;   //LTE
   t_e = xplasma->t_e;
@@ -115,6 +116,7 @@ variable_temperature (xplasma, mode)
   for (nion = 0; nion < nions; nion++)
   {
     newden[nion] = xplasma->density[nion];
+    xtemp_guess[nion] = t_e;
 
     /* Here we populate the recombination to ground state correction factor used in the LM and Sim ionization
      * equations.  Mode 2 imples we are include the dielectronic correction. There is no recombination fudge for 
@@ -199,7 +201,7 @@ variable_temperature (xplasma, mode)
 
         /* now we need to work out the correct temperature to use */
         xip = ion[nion - 1].ip; //the IP is that from the lower to the upper of the pair
-        xtemp = zbrent (temp_func, MIN_TEMP, 1e8, 10);  //work out correct temperature
+        xtemp = xtemp_guess[nion] = temp_func_solve (xtemp_guess[nion], MIN_TEMP, 1e8, 10);    //work out correct temperature
 
 
         /* given this temperature, we need the pair of partition functions for these ions */
@@ -508,3 +510,71 @@ temp_func (solv_temp)
 
   return (answer);
 }
+
+
+
+/* temp_func_solve finds the zero of temp_func between tmin and tmax, to an accuracy
+   of tol in K, starting from the guess tguess.
+
+   temp_func is simple enough that its derivative can be written down, and in terms
+   of u = ln T it is d(temp_func)/du = 1.5 + xip / (k T), which is always positive.
+   The function is also concave in u, so Newton steps in u converge quickly and
+   without oscillation.  Since ne changes only a little from one pass of the ne
+   loop in variable_temperature to the next, the answer from the last pass is a
+   very good guess, and usually one or two steps are all that is needed.  This
+   replaced a call to zbrent over the whole range MIN_TEMP to 1e8.
+
+   If the zero lies outside the range, the nearest end of the range is returned.
+   The number of evaluations is added to npair_temp_evals.
+*/
+
+#define TEMP_FUNC_MAXITER 50
+
+double
+temp_func_solve (tguess, tmin, tmax, tol)
+     double tguess, tmin, tmax, tol;
+{
+  double u, umin, umax, du, t, t_new;
+  int niter;
+
+  umin = log (tmin);
+  umax = log (tmax);
+
+  if (tguess < tmin || tguess > tmax)
+    tguess = sqrt (tmin * tmax);
+
+  u = log (tguess);
+  t = tguess;
+  npair_temp_calls++;
+
+  for (niter = 0; niter < TEMP_FUNC_MAXITER; niter++)
+  {
+    npair_temp_evals++;
+    du = -temp_func (t) / (1.5 + xip / (BOLTZMANN * t));
+
+    if (u + du < umin)
+    {
+      if (u == umin)
+        return (tmin);
+      u = umin;
+    }
+    else if (u + du > umax)
+    {
+      if (u == umax)
+        return (tmax);
+      u = umax;
+    }
+    else
+      u += du;
+
+    t_new = exp (u);
+    if (fabs (t_new - t) < tol)
+      return (t_new);
+    t = t_new;
+  }
+
+  Error ("temp_func_solve: No convergence for ip %8.2e ne %8.2e, returning %8.2e\n", xip, xxxne, t);
+  return (t);
+}
+
+#undef TEMP_FUNC_MAXITER
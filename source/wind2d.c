@@ -193,6 +193,8 @@ define_wind ()
     }
 
   }
+  vwind_coef_ok = FALSE;        // The velocities have changed
+  wind_bounds_ok = FALSE;
   wind_complete (w);
 
   /* Now define the valid volumes of each cell and also determine whether the cells are in all
@@ -471,6 +473,8 @@ be optional which variables beyond here are moved to structures othere than Wind
   /* zero the counters which record diagnositcs from mean_intensity */
   nerr_Jmodel_wrong_freq = 0;
   nerr_no_Jmodel = 0;
+  nte_solve_calls = nte_solve_evals = 0;
+  npair_temp_calls = npair_temp_evals = 0;
 
 /*
      Check that m_dot is correct.  This calculation is very approximate.  It only calculates mdot
@@ -695,6 +699,8 @@ vwind_xyz (ndom, p, v)
   double ctheta, stheta;
   double x, frac[4];
   int nn, nnn[4], nelem;
+  int ix, iz;
+  double dr, dz, *c;
 
 
 
@@ -703,16 +709,30 @@ vwind_xyz (ndom, p, v)
     Error ("vwind_xyz: Received invalid domain  %d\n", ndom);
   }
 
-  coord_fraction (ndom, 0, p->x, nnn, frac, &nelem);
-
-  for (i = 0; i < 3; i++)
+  if (zdom[ndom].coord_type == CYLVAR)
   {
+    coord_fraction (ndom, 0, p->x, nnn, frac, &nelem);
 
-    x = 0;
-    for (nn = 0; nn < nelem; nn++)
-      x += wmain[nnn[nn]].v[i] * frac[nn];
+    for (i = 0; i < 3; i++)
+    {
+
+      x = 0;
+      for (nn = 0; nn < nelem; nn++)
+        x += wmain[nnn[nn]].v[i] * frac[nn];
 
-    vv[i] = x;
+      vv[i] = x;
+    }
+  }
+  else
+  {
+    /* Use the precalculated coefficients for the cell */
+    if (!vwind_coef_ok)
+      vwind_coef_init ();
+
+    coord_locate (ndom, 0, p->x, &ix, &dr, &iz, &dz);
+    c = &vwind_coef[12 * (zdom[ndom].nstart + ix * zdom[ndom].mdim + iz)];
+    for (i = 0; i < 3; i++, c += 4)
+      vv[i] = c[0] + c[1] * dr + (c[2] + c[3] * dr) * dz;
   }
 
   rho = sqrt (p->x[0] * p->x[0] + p->x[1] * p->x[1]);
@@ -754,6 +774,104 @@ vwind_xyz (ndom, p, v)
 }
 
 
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	vwind_coef_init() calculates the coefficients vwind_xyz uses to 
+	interpolate the velocity within each cell
+ 
+ Arguments:		
+
+Returns:
+	0 	on successful completion
+ 
+Description:
+	For each element of wmain, and each component of the velocity,
+	the bilinear interpolation
+
+	v = (1-dr)(1-dz) v00 + dr (1-dz) v10 + (1-dr) dz v01 + dr dz v11
+
+	is rewritten as c0 + c1 dr + c2 dz + c3 dr dz, where v00 is the
+	velocity of the element, v10 that of the next element in x (or r), 
+	v01 the next in z (or theta), and v11 the next in both.  For 
+	spherical grids only c0 and c1 are used.  Elements on the outer 
+	edges of the grid, which coord_locate never returns, are left 0.
+
+Notes:
+	vwind_coef_ok must be set to FALSE whenever the velocities in wmain
+	change, so that the coefficients are remade on the next call to
+	vwind_xyz.  cylvar grids are not regular in z, and still use
+	coord_fraction.
+
+**************************************************************/
+
+int
+vwind_coef_init ()
+{
+  int ndom, n, nn, ix, iz, i, ndim, mdim;
+  double *c, *v00, *v10, *v01, *v11;
+
+  if ((vwind_coef = realloc (vwind_coef, 12 * NDIM2 * sizeof (double))) == NULL)
+  {
+    Error ("vwind_coef_init: Could not allocate coefficients for %d cells\n", NDIM2);
+    exit (0);
+  }
+
+  for (n = 0; n < 12 * NDIM2; n++)
+    vwind_coef[n] = 0.0;
+
+  for (ndom = 0; ndom < geo.ndomain; ndom++)
+  {
+    if (zdom[ndom].coord_type == CYLVAR)
+      continue;
+
+    ndim = zdom[ndom].ndim;
+    mdim = zdom[ndom].mdim;
+
+    for (n = zdom[ndom].nstart; n < zdom[ndom].nstop; n++)
+    {
+      nn = n - zdom[ndom].nstart;
+      c = &vwind_coef[12 * n];
+
+      if (zdom[ndom].coord_type == SPHERICAL)
+      {
+        if (nn > ndim - 2)
+          continue;
+        for (i = 0; i < 3; i++)
+        {
+          c[4 * i] = wmain[n].v[i];
+          c[4 * i + 1] = wmain[n + 1].v[i] - wmain[n].v[i];
+        }
+      }
+      else
+      {
+        ix = nn / mdim;
+        iz = nn - ix * mdim;
+        if (ix > ndim - 2 || iz > mdim - 2)
+          continue;
+        v00 = wmain[n].v;
+        v10 = wmain[n + mdim].v;
+        v01 = wmain[n + 1].v;
+        v11 = wmain[n + mdim + 1].v;
+        for (i = 0; i < 3; i++)
+        {
+          c[4 * i] = v00[i];
+          c[4 * i + 1] = v10[i] - v00[i];
+          c[4 * i + 2] = v01[i] - v00[i];
+          c[4 * i + 3] = v11[i] - v10[i] - v01[i] + v00[i];
+        }
+      }
+    }
+  }
+
+  vwind_coef_ok = TRUE;
+
+  return (0);
+}
+
+
 /***********************************************************
                                        Space Telescope Science Institute
 
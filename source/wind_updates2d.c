@@ -120,6 +120,7 @@ WindPtr (w);
   double nsh_lum_metals;
   int my_nmin, my_nmax;         //Note that these variables are still used even without MPI on
   int ndom;
+  int nskipped;                 /* The number of cells not updated in incremental mode */
   FILE *fptr, *fopen ();        /*This is the file to communicate with zeus */
 
 
@@ -136,7 +137,7 @@ WindPtr (w);
   /* the commbuffer needs to be larger enough to pack all variables in MPI_Pack and MPI_Unpack routines NSH 1407 - the 
      NIONS changed to nions for the 12 arrays in plasma that are now dynamically allocated */
   size_of_commbuffer =
-    8 * (12 * nions + NLTE_LEVELS + 2 * NTOP_PHOT + 12 * NXBANDS + 2 * LPDF + NAUGER + 107) * (floor (NPLASMA / np_mpi_global) + 1);
+    8 * (12 * nions + NLTE_LEVELS + 2 * NTOP_PHOT + 13 * NXBANDS + 2 * LPDF + NAUGER + 112) * (floor (NPLASMA / np_mpi_global) + 1);
   commbuffer = (char *) malloc (size_of_commbuffer * sizeof (char));
 
   /* JM 1409 -- Initialise parallel only variables */
@@ -146,6 +147,7 @@ WindPtr (w);
 #endif
   dt_r = dt_e = 0.0;
   iave = 0;
+  nskipped = 0;
   nmax_r = nmax_e = -1;
   t_r_ave_old = t_r_ave = t_e_ave_old = t_e_ave = 0.0;
 
@@ -317,9 +319,21 @@ WindPtr (w);
       plasmamain[n].lum_adiabatic = 0.0;
 
 
-    /* Calculate the densities in various ways depending on the ioniz_mode */
+    /* Calculate the densities in various ways depending on the ioniz_mode, unless we are
+       running incrementally and nothing has changed in this cell */
 
-    ion_abundances (&plasmamain[n], geo.ioniz_mode);
+    if (geo.incremental_update && incremental_skip (&plasmamain[n]))
+    {
+      plasmamain[n].nskip_update++;
+      nskipped++;
+    }
+    else
+    {
+      perf_start (PERF_IONIZATION);
+      ion_abundances (&plasmamain[n], geo.ioniz_mode);
+      perf_stop (PERF_IONIZATION);
+      incremental_store (&plasmamain[n]);
+    }
 
 
 
@@ -465,6 +479,12 @@ WindPtr (w);
         MPI_Pack (&plasmamain[n].ip_direct, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
         MPI_Pack (&plasmamain[n].ip_scatt, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
         MPI_Pack (&plasmamain[n].xi, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (&plasmamain[n].j_ref, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (&plasmamain[n].ave_freq_ref, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (&plasmamain[n].ip_ref, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (plasmamain[n].xj_ref, NXBANDS, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (&plasmamain[n].ncycles_converged, 1, MPI_INT, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
+        MPI_Pack (&plasmamain[n].nskip_update, 1, MPI_INT, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
         MPI_Pack (&dt_e, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
         MPI_Pack (&dt_r, 1, MPI_DOUBLE, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
         MPI_Pack (&nmax_e, 1, MPI_INT, commbuffer, size_of_commbuffer, &position, MPI_COMM_WORLD);
@@ -598,6 +618,12 @@ WindPtr (w);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].ip_direct, 1, MPI_DOUBLE, MPI_COMM_WORLD);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].ip_scatt, 1, MPI_DOUBLE, MPI_COMM_WORLD);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].xi, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].j_ref, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].ave_freq_ref, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].ip_ref, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, plasmamain[n].xj_ref, NXBANDS, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].ncycles_converged, 1, MPI_INT, MPI_COMM_WORLD);
+        MPI_Unpack (commbuffer, size_of_commbuffer, &position, &plasmamain[n].nskip_update, 1, MPI_INT, MPI_COMM_WORLD);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &dt_e_temp, 1, MPI_DOUBLE, MPI_COMM_WORLD);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &dt_r_temp, 1, MPI_DOUBLE, MPI_COMM_WORLD);
         MPI_Unpack (commbuffer, size_of_commbuffer, &position, &nmax_e_temp, 1, MPI_INT, MPI_COMM_WORLD);
@@ -754,6 +780,20 @@ WindPtr (w);
   nerr_Jmodel_wrong_freq = 0;
   nerr_no_Jmodel = 0;
 
+  if (geo.incremental_update)
+    Log ("wind_update: incremental update: %d of %d cells carried forward without a new solution, this cycle, this thread\n",
+         nskipped, my_nmax - my_nmin);
+
+  /* Report how hard the temperature solvers had to work, and zero their counters */
+  if (nte_solve_calls > 0)
+    Log ("wind_update: calc_te: %d cells, %.2f evaluations of zero_emit per cell, this cycle, this thread\n",
+         nte_solve_calls, ((double) nte_solve_evals) / nte_solve_calls);
+  if (npair_temp_calls > 0)
+    Log ("wind_update: temp_func_solve: %d calls, %.2f iterations per call, this cycle, this thread\n",
+         npair_temp_calls, ((double) npair_temp_evals) / npair_temp_calls);
+  nte_solve_calls = nte_solve_evals = 0;
+  npair_temp_calls = npair_temp_evals = 0;
+
 
 
   asum = wind_luminosity (0.0, VERY_BIG);       /*We call wind_luminosity here to obtain an up to date set of cooling rates */
@@ -835,6 +875,10 @@ WindPtr (w);
 
   check_convergence ();
 
+  /* Work out how photons should be shared among the bands in the next cycle */
+
+  bands_adapt (&xband);
+
   /* Summarize the radiative temperatures (ksl 04 mar) */
 
   xtemp_rad (w);
@@ -1261,3 +1305,120 @@ wind_ip ()
   }
   return (0);
 }
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis: incremental_skip(xplasma) decides whether the ionization and temperature
+	of a cell need to be solved for again in this cycle, when geo.incremental_update
+	is on.
+
+ Arguments:
+	PlasmaPtr xplasma;
+
+Returns:
+	1 if the cell can be carried forward unchanged, 0 if it must be updated
+
+Description:
+	A cell is only skipped if it has been converged for at least INCREMENTAL_NCONVERGED
+	updates, this is not a cycle in which every cell is updated, and none of the
+	radiation field estimators j, ave_freq, ip and xj have moved from the values they
+	had at the last real update by more than geo.incremental_nsigma times their
+	Monte Carlo noise.  The noise is estimated as 1/sqrt(N) of the value, where N
+	is the number of photon passages through the cell (or through the cell in the
+	band in the case of xj).
+
+Notes:
+	The estimators must already have been normalised when this is called.  A skipped
+	cell keeps its densities, t_e, cooling rates and convergence flags, but t_r, w
+	and the heating are those measured in this cycle.
+
+History:
+
+**************************************************************/
+
+int
+incremental_skip (xplasma)
+     PlasmaPtr xplasma;
+{
+  int i;
+  double noise;
+
+  if (geo.wcycle % geo.incremental_refresh == 0)
+    return (0);
+
+  if (xplasma->ncycles_converged < INCREMENTAL_NCONVERGED || xplasma->ntot == 0)
+    return (0);
+
+  noise = geo.incremental_nsigma / sqrt ((double) xplasma->ntot);
+
+  if (fabs (xplasma->j - xplasma->j_ref) > noise * xplasma->j_ref)
+    return (0);
+  if (fabs (xplasma->ave_freq - xplasma->ave_freq_ref) > noise * xplasma->ave_freq_ref)
+    return (0);
+  if (fabs (xplasma->ip - xplasma->ip_ref) > noise * xplasma->ip_ref)
+    return (0);
+
+  for (i = 0; i < geo.nxfreq; i++)
+  {
+    if (xplasma->nxtot[i] > 0)
+    {
+      noise = geo.incremental_nsigma / sqrt ((double) xplasma->nxtot[i]);
+      if (fabs (xplasma->xj[i] - xplasma->xj_ref[i]) > noise * xplasma->xj_ref[i])
+        return (0);
+    }
+    else if (xplasma->xj_ref[i] > 0)
+    {
+      return (0);
+    }
+  }
+
+  return (1);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis: incremental_store(xplasma) records the radiation field estimators used
+	in the update of a cell, and whether the cell converged, so that
+	incremental_skip can decide whether the next update is needed.
+
+ Arguments:
+	PlasmaPtr xplasma;
+
+Returns:
+
+Description:
+	This is called after every real update of a cell, whether or not the
+	incremental update is on, so that the reference values are in place
+	if it is switched on in a restart.
+
+History:
+
+**************************************************************/
+
+int
+incremental_store (xplasma)
+     PlasmaPtr xplasma;
+{
+  int i;
+
+  xplasma->j_ref = xplasma->j;
+  xplasma->ave_freq_ref = xplasma->ave_freq;
+  xplasma->ip_ref = xplasma->ip;
+  for (i = 0; i < NXBANDS; i++)
+    xplasma->xj_ref[i] = xplasma->xj[i];
+
+  if (xplasma->converge_whole == 0)
+    xplasma->ncycles_converged++;
+  else
+    xplasma->ncycles_converged = 0;
+
+  xplasma->nskip_update = 0;
+
+  return (0);
+}
@@ -6,6 +6,7 @@
  Synopsis:
 	wind_save(w,filename)
 	wind_read(filename)
+	wind_read_select(filename,parts)
 	spec_save(filename)
 	spec_read(filename)
 
@@ -159,17 +160,76 @@ in the plasma structure */
 	14jul	nsh	Code added to read in variable length arrays in plasma structure
 	15aug	ksl	Updated to read domain structure
 	15oct	ksl	Updated to read disk and qdisk stuctures
+
+   wind_read reads everything in the windsave file; wind_read_select
+   reads only the parts of the plasma and macro atom arrays given by
+   parts, an or of the WIND_READ flags in python.h, skipping over the
+   others.  This is for post-processing tools such as windsave2table
+   which only need a few quantities, since the skipped arrays are
+   most of the file.  The arrays for the skipped parts are still
+   allocated, and are left as zero, except that macromain is not
+   allocated at all unless WIND_READ_MACRO is set.
+
+   With WIND_READ_KEEP_ATOMIC in parts, the atomic data are only read if
+   they are not already those named in the windsave file, which saves
+   time when reading many windsave files made with the same data.
 */
 
 int
 wind_read (filename)
      char filename[];
+{
+  return (wind_read_select (filename, WIND_READ_ALL));
+}
+
+
+/* wind_read_array reads n items into x if want is set, and otherwise skips over them.  Skips
+   are saved up in wind_read_skip so that a run of skipped arrays costs a single fseek, which
+   is made before the next read. */
+
+long wind_read_skip = 0;
+
+/* The atomic data file which was read by the last call to wind_read_select */
+char wind_read_atomic[LINELENGTH] = "";
+
+int
+wind_read_array (x, size, n, want, fptr)
+     void *x;
+     size_t size;
+     int n, want;
+     FILE *fptr;
+{
+  if (!want)
+  {
+    wind_read_skip += (long) size *n;
+    return (n);
+  }
+  if (wind_read_skip > 0)
+  {
+    fseek (fptr, wind_read_skip, SEEK_CUR);
+    wind_read_skip = 0;
+  }
+  return (fread (x, size, n, fptr));
+}
+
+
+int
+wind_read_select (filename, parts)
+     char filename[];
+     int parts;
 {
   FILE *fptr, *fopen ();
   int n, m;
+  int dens, rates, scat, lev;
   char line[LINELENGTH];
   char version[LINELENGTH];
 
+  wind_read_skip = 0;
+  dens = parts & WIND_READ_DENSITY;
+  rates = parts & WIND_READ_RATES;
+  scat = parts & WIND_READ_SCATTERS;
+  lev = parts & WIND_READ_LEVELS;
+
   if ((fptr = fopen (filename, "r")) == NULL)
   {
     return (-1);
@@ -186,7 +246,11 @@ wind_read (filename)
    * with macro atoms, especially but likely to be a good idea ovrall
    */
 
-  get_atomic_data (geo.atomic_filename);
+  if (!(parts & WIND_READ_KEEP_ATOMIC) || strcmp (geo.atomic_filename, wind_read_atomic) != 0)
+  {
+    get_atomic_data (geo.atomic_filename);
+    strcpy (wind_read_atomic, geo.atomic_filename);
+  }
 
 
 /* Now allocate space for the wind array */
@@ -200,6 +264,8 @@ wind_read (filename)
 
   calloc_wind (NDIM2);
   n += fread (wmain, sizeof (wind_dummy), NDIM2, fptr);
+  vwind_coef_ok = FALSE;        // The velocities may have changed
+  wind_bounds_ok = FALSE;
 
   /* Read the disk and qdisk structures */
 
@@ -218,45 +284,39 @@ wind_read (filename)
   for (m = 0; m < NPLASMA; m++)
   {
 
-    n += fread (plasmamain[m].density, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].partition, sizeof (double), nions, fptr);
+    n += wind_read_array (plasmamain[m].density, sizeof (double), nions, dens, fptr);
+    n += wind_read_array (plasmamain[m].partition, sizeof (double), nions, dens, fptr);
 
-    n += fread (plasmamain[m].PWdenom, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].PWdtemp, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].PWnumer, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].PWntemp, sizeof (double), nions, fptr);
+    n += wind_read_array (plasmamain[m].PWdenom, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].PWdtemp, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].PWnumer, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].PWntemp, sizeof (double), nions, rates, fptr);
 
-    n += fread (plasmamain[m].ioniz, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].recomb, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].inner_recomb, sizeof (double), nions, fptr);
+    n += wind_read_array (plasmamain[m].ioniz, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].recomb, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].inner_recomb, sizeof (double), nions, rates, fptr);
 
 
-    n += fread (plasmamain[m].scatters, sizeof (int), nions, fptr);
-    n += fread (plasmamain[m].xscatters, sizeof (double), nions, fptr);
+    n += wind_read_array (plasmamain[m].scatters, sizeof (int), nions, scat, fptr);
+    n += wind_read_array (plasmamain[m].xscatters, sizeof (double), nions, scat, fptr);
 
-    n += fread (plasmamain[m].heat_ion, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].lum_ion, sizeof (double), nions, fptr);
-    n += fread (plasmamain[m].lum_inner_ion, sizeof (double), nions, fptr);
-	
-    n += fread (plasmamain[m].levden, sizeof (double), nlte_levels, fptr);
-    n += fread (plasmamain[m].recomb_simple, sizeof (double), nphot_total, fptr);
-    n += fread (plasmamain[m].kbf_use, sizeof (double), nphot_total, fptr);
-	
-	
-	
+    n += wind_read_array (plasmamain[m].heat_ion, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].lum_ion, sizeof (double), nions, rates, fptr);
+    n += wind_read_array (plasmamain[m].lum_inner_ion, sizeof (double), nions, rates, fptr);
 
-	
-	
-	
+    n += wind_read_array (plasmamain[m].levden, sizeof (double), nlte_levels, lev, fptr);
+    n += wind_read_array (plasmamain[m].recomb_simple, sizeof (double), nphot_total, lev, fptr);
+    n += wind_read_array (plasmamain[m].kbf_use, sizeof (double), nphot_total, lev, fptr);
 
   }
 
 
   /*Allocate space for macro-atoms */
 
-  if (geo.nmacro > 0)
+  if (geo.nmacro > 0 && (parts & WIND_READ_MACRO))
   {
     calloc_macro (NPLASMA);
+    wind_read_array (macromain, sizeof (macro_dummy), 0, 1, fptr);      //Catch up with any arrays skipped above
     n += fread (macromain, sizeof (macro_dummy), NPLASMA, fptr);
     calloc_estimators (NPLASMA);
 
@@ -345,6 +405,65 @@ wind_complete (w)
   return (0);
 }
 
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	spectrum_alloc allocates xxspec and the arrays which hold the spectra
+
+Arguments:		
+	int nspec		The number of spectra
+	int nwave		The number of frequency bins in each spectrum
+
+Returns:
+	0 
+ 
+Description:	
+	The four arrays (f, lf, f_wind, lf_wind) of each spectrum are 
+	carved out of a single block, so that their size is set by 
+	geo.nwave rather than when python is compiled.  The global 
+	nspectra is set here.
+
+Notes:
+	Since the arrays are not part of the spectrum structure, spec_save
+	and spec_read write and read them separately.  This is here rather
+	than in spectra.c because spec_read needs it in py_wind and 
+	windsave2table.
+
+**************************************************************/
+
+int
+spectrum_alloc (nspec, nwave)
+     int nspec, nwave;
+{
+  int n;
+  double *block;
+
+  xxspec = calloc (sizeof (spectrum_dummy), nspec);
+  block = calloc (sizeof (double), 4 * nspec * nwave);
+  if (xxspec == NULL || block == NULL)
+  {
+    Error ("spectrum_alloc: Could not allocate memory for %d spectra with %d wavelengths\n", nspec, nwave);
+    exit (0);
+  }
+
+  for (n = 0; n < nspec; n++)
+  {
+    xxspec[n].nwave = nwave;
+    xxspec[n].f = block;
+    xxspec[n].lf = block + nwave;
+    xxspec[n].f_wind = block + 2 * nwave;
+    xxspec[n].lf_wind = block + 3 * nwave;
+    block += 4 * nwave;
+  }
+
+  nspectra = nspec;             /* Note that nspectra is a global variable */
+
+  return (0);
+}
+
+
+
 int
 spec_save (filename)
      char filename[];
@@ -352,7 +471,7 @@ spec_save (filename)
 
   FILE *fptr, *fopen ();
   char line[LINELENGTH];
-  int n;
+  int n, i;
 
   if ((fptr = fopen (filename, "w")) == NULL)
   {
@@ -363,6 +482,15 @@ spec_save (filename)
   sprintf (line, "Version %s  nspectra %d\n", VERSION, nspectra);
   n = fwrite (line, sizeof (line), 1, fptr);
   n += fwrite (xxspec, sizeof (spectrum_dummy), nspectra, fptr);
+
+  /* The spectra themselves are not part of the structures, see spectrum_alloc */
+  for (i = 0; i < nspectra; i++)
+  {
+    n += fwrite (xxspec[i].f, sizeof (double), xxspec[i].nwave, fptr);
+    n += fwrite (xxspec[i].lf, sizeof (double), xxspec[i].nwave, fptr);
+    n += fwrite (xxspec[i].f_wind, sizeof (double), xxspec[i].nwave, fptr);
+    n += fwrite (xxspec[i].lf_wind, sizeof (double), xxspec[i].nwave, fptr);
+  }
   fclose (fptr);
 
   return (n);
@@ -374,7 +502,8 @@ spec_read (filename)
      char filename[];
 {
   FILE *fptr, *fopen ();
-  int n;
+  int n, i;
+  SpecPtr xspec;
 
   char line[LINELENGTH];
   char version[LINELENGTH];
@@ -391,18 +520,35 @@ spec_read (filename)
   Log ("Reading specfile %s with %d spectra created with python version %s with python version %s\n", filename, nspectra, version, VERSION);
 
 
-  /* First allocate space */
+  /* First read the structures, which tell us how large the spectra are */
 
-  xxspec = calloc (sizeof (spectrum_dummy), nspectra);
-  if (xxspec == NULL)
+  xspec = calloc (sizeof (spectrum_dummy), nspectra);
+  if (xspec == NULL)
   {
-    Error ("spectrum_init: Could not allocate memory for %d spectra with %d wavelengths\n", nspectra, NWAVE);
+    Error ("spec_read: Could not allocate memory for %d spectra\n", nspectra);
     exit (0);
   }
+  n += fread (xspec, sizeof (spectrum_dummy), nspectra, fptr);
 
-/* Now read the rest of the file */
+/* Now allocate space for the spectra and read the rest of the file.  The pointers
+   to the spectra in the structures that were read are those of the run which wrote
+   the file, and must be replaced. */
 
-  n += fread (xxspec, sizeof (spectrum_dummy), nspectra, fptr);
+  spectrum_alloc (nspectra, xspec[0].nwave);
+  for (i = 0; i < nspectra; i++)
+  {
+    xspec[i].f = xxspec[i].f;
+    xspec[i].lf = xxspec[i].lf;
+    xspec[i].f_wind = xxspec[i].f_wind;
+    xspec[i].lf_wind = xxspec[i].lf_wind;
+    xxspec[i] = xspec[i];
+
+    n += fread (xxspec[i].f, sizeof (double), xxspec[i].nwave, fptr);
+    n += fread (xxspec[i].lf, sizeof (double), xxspec[i].nwave, fptr);
+    n += fread (xxspec[i].f_wind, sizeof (double), xxspec[i].nwave, fptr);
+    n += fread (xxspec[i].lf_wind, sizeof (double), xxspec[i].nwave, fptr);
+  }
+  free (xspec);
 
   fclose (fptr);
 
@@ -20,6 +20,11 @@ Description:
 	
 Notes:
 
+	Each table is written both as ascii, and in a binary columnar
+	form, e.g. rootname.master.bin, which is much quicker to read
+	when summarizing a large number of models; see write_table_binary.
+	Only the parts of the windsave file needed for the tables are read.
+
 	The main difficulty with this program is that one needs to be consistent
 	regarding the size of the arrays that one stuffs the variables into.  
 	As now written, if one wants to access a variable in wmain, one needs to
@@ -36,9 +41,14 @@ History:
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "atomic.h"
 #include "python.h"
 
+/* The elements for which ion tables are made */
+#define NTABLE_ELEMENTS 5
+int table_elements[NTABLE_ELEMENTS] = { 6, 7, 8, 14, 26 };
 
 
 int
@@ -48,15 +58,13 @@ main (argc, argv)
 {
 
 
-  int ochoice;
-
   char root[LINELENGTH], input[LINELENGTH];
-  char rootname[LINELENGTH];    // this takes into account domains
-  char outputfile[LINELENGTH];
-  char windsavefile[LINELENGTH];
+  char outroot[LINELENGTH];
   char parameter_file[LINELENGTH];
-  int create_master_table (), create_ion_table ();
-  int ndom;
+  char **roots;
+  int windsave2table_model (), batch_tables (), read_root_list (), windsave2table_help ();
+  int get_windsave_root ();
+  int i, nroots, njobs, batch;
 
 
   // py_wind uses rdpar, but only in an interactive mode. As a result 
@@ -67,66 +75,622 @@ main (argc, argv)
   /* Next command stops Debug statements printing out in py_wind */
   Log_set_verbosity (3);
 
-  if (argc == 1)
+  /* Use the binary cache of the atomic data */
+  atomic_cache = ATOMIC_CACHE_READ | ATOMIC_CACHE_WRITE;
+
+  /* Every argument which is not a switch is the root of a model.  With more than one
+   * model, or a list of them, the models are processed in batch mode */
+
+  roots = (char **) calloc (sizeof (char *), argc + 1);
+  nroots = 0;
+  njobs = 1;
+  batch = 0;
+  strcpy (outroot, "windsave2table");
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp (argv[i], "-h") == 0)
+    {
+      windsave2table_help ();
+    }
+    else if (strcmp (argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      njobs = atoi (argv[++i]);
+      if (njobs < 1)
+        njobs = 1;
+    }
+    else if (strcmp (argv[i], "-o") == 0 && i + 1 < argc)
+    {
+      strcpy (outroot, argv[++i]);
+    }
+    else if (strcmp (argv[i], "-l") == 0 && i + 1 < argc)
+    {
+      nroots = read_root_list (argv[++i], &roots, nroots);
+      batch = 1;
+    }
+    else if (strncmp (argv[i], "-", 1) == 0)
+    {
+      Error ("windsave2table: unknown switch %s\n", argv[i]);
+      windsave2table_help ();
+    }
+    else
+    {
+      get_windsave_root (root, argv[i]);
+      roots[nroots++] = strdup (root);
+    }
+  }
+
+  if (nroots == 0)
   {
     printf ("Root for wind file :");
     fgets (input, LINELENGTH, stdin);
-    get_root (root, input);
+    get_windsave_root (root, input);
+    roots[nroots++] = strdup (root);
   }
-  else
+
+  if (batch || nroots > 1)
   {
-    strcpy (input, argv[argc - 1]);
-    get_root (root, input);
+    batch_tables (nroots, roots, njobs, outroot);
   }
+  else if (windsave2table_model (roots[0], WIND_READ_DENSITY) < 0)
+  {
+    exit (0);
+  }
+  return (0);
+}
 
 
-  printf ("Reading data from file %s\n", root);
 
-  /* Now create the names of all the files which will be written */
+/***********************************************************
+                                       Space Telescope Science Institute
 
-  strcpy (windsavefile, root);
-  strcpy (outputfile, root);
+ Synopsis:
+	windsave2table_help prints the usage of windsave2table and exits
 
-  strcat (windsavefile, ".wind_save");
-  strcat (outputfile, ".txt");
+**************************************************************/
+
+int
+windsave2table_help ()
+{
+
+  char *some_help;
+
+  some_help = "\
+\n\
+Usage: windsave2table [-h] [-j njobs] [-o outroot] [-l listfile] root [root ...] \n\
+\n\
+Writes tables of key variables from root.wind_save.  If more than one root is given,\n\
+or a list of them in listfile, one root per line, the tables are made for all of the\n\
+models and then combined into outroot.<domain>.<table>.txt and .bin, with a column\n\
+giving the number of the model in the list.\n\
+\n\
+	-h		Print this help message and exit\n\
+	-j njobs	Process up to njobs models at a time (batch mode only)\n\
+	-o outroot	Root name of the combined tables (default windsave2table)\n\
+	-l listfile	Read the roots of the models from listfile\n\
+\n";
+
+  printf ("%s\n", some_help);
+
+  exit (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	windsave2table_model reads one windsave file and writes the tables for it
+
+Arguments:		
 
+	root		the root of the model
+	parts		the parts of the windsave file to read, see wind_read_select
 
-/* Read in the wind file */
+Returns:
 
-  if (wind_read (windsavefile) < 0)
+	0 on success, -1 if the windsave file could not be read
+ 
+Description:	
+
+	The tables only need the ion densities from the variable length 
+	arrays of the windsave file, so the rest are skipped.  wind_read_select
+	also reads the atomic data.
+
+Notes:
+
+**************************************************************/
+
+int
+windsave2table_model (root, parts)
+     char root[];
+     int parts;
+{
+  char rootname[LINELENGTH];    // this takes into account domains
+  char windsavefile[LINELENGTH];
+  int create_master_table (), create_ion_table ();
+  int ndom, i;
+
+  printf ("Reading data from file %s\n", root);
+
+  strcpy (windsavefile, root);
+  strcat (windsavefile, ".wind_save");
+
+  if (wind_read_select (windsavefile, parts) < 0)
   {
-    Error ("py_wind: Could not open %s", windsavefile);
-    exit (0);
+    Error ("windsave2table: Could not open %s\n", windsavefile);
+    return (-1);
   }
 
 
   printf ("Read wind_file %s\n", windsavefile);
 
-  get_atomic_data (geo.atomic_filename);
-
   printf ("Read Atomic data from %s\n", geo.atomic_filename);
 
 
-  ochoice = 1;
-
-
   for (ndom = 0; ndom < geo.ndomain; ndom++)
   {
 
     sprintf (rootname, "%s.%d", root, ndom);
 
     create_master_table (ndom, rootname);
-    create_ion_table (ndom, rootname, 6);
-    create_ion_table (ndom, rootname, 7);
-    create_ion_table (ndom, rootname, 8);
-    create_ion_table (ndom, rootname, 14);
-    create_ion_table (ndom, rootname, 26);
+    for (i = 0; i < NTABLE_ELEMENTS; i++)
+      create_ion_table (ndom, rootname, table_elements[i]);
+  }
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	get_windsave_root gets the root of a model from a name which may 
+	be either the root itself, or the name of the windsave file
+
+Arguments:		
+
+	root		the root, which is returned
+	input		the name
+
+Returns:
+
+	0
+ 
+**************************************************************/
+
+int
+get_windsave_root (root, input)
+     char root[], input[];
+{
+  int n;
+
+  get_root (root, input);
+  n = strlen (root) - strlen (".wind_save");
+  if (n > 0 && strcmp (&root[n], ".wind_save") == 0)
+    root[n] = '\0';
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	read_root_list adds the roots of models listed in a file to a list of roots
+
+Arguments:		
+
+	filename	the file, with one root per line
+	roots		the list, which is enlarged as necessary
+	nroots		the number of roots already in the list
+
+Returns:
+
+	The number of roots in the list
+ 
+Notes:
+	Blank lines and lines starting with # are ignored.
+
+**************************************************************/
+
+int
+read_root_list (filename, roots, nroots)
+     char filename[];
+     char ***roots;
+     int nroots;
+{
+  FILE *fptr;
+  char line[LINELENGTH], root[LINELENGTH], word[LINELENGTH];
+  int nalloc;
+  int get_windsave_root ();
+
+  if ((fptr = fopen (filename, "r")) == NULL)
+  {
+    Error ("read_root_list: Could not open %s\n", filename);
+    exit (0);
+  }
+
+  nalloc = nroots;
+  while (fgets (line, LINELENGTH, fptr) != NULL)
+  {
+    if (sscanf (line, "%s", word) != 1 || word[0] == '#')
+      continue;
+    if (nroots >= nalloc)
+    {
+      nalloc = 2 * nalloc + 16;
+      *roots = (char **) realloc (*roots, nalloc * sizeof (char *));
+    }
+    get_windsave_root (root, word);
+    (*roots)[nroots++] = strdup (root);
+  }
+
+  fclose (fptr);
+  return (nroots);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	batch_tables makes the tables for a number of models, and combines them
+
+Arguments:		
+
+	nroots		the number of models
+	roots		their roots
+	njobs		the number of models to process at once
+	outroot		the root name for the combined tables
+
+Returns:
+
+	0
+ 
+Description:	
+
+	The atomic data are read here once, from the windsave file of the 
+	first model.  Each model is then processed in its own process, forked 
+	from this one, so that it starts with the atomic data already in place
+	and only has to read them again if its windsave file names a different
+	atomic data file.  Up to njobs of these run at once.
+
+	Once they have all finished, the tables for the individual models are 
+	combined by combine_tables.  If any of the models could not be 
+	processed, the tables are not combined, since the combined tables 
+	would silently be missing that model.
+
+Notes:
+
+	The binary tables of the models are removed before the models are
+	processed, so that a table left over from an earlier run is never
+	combined in place of one which could not be made this time.
+
+	A process which stops with exit (0) after an error looks as if it 
+	succeeded, so each model is only marked as done, by mark_tables_done,
+	once windsave2table_model has returned.  combine_tables checks these
+	marks.
+
+**************************************************************/
+
+int
+batch_tables (nroots, roots, njobs, outroot)
+     int nroots;
+     char *roots[];
+     int njobs;
+     char outroot[];
+{
+  char windsavefile[LINELENGTH];
+  int windsave2table_model (), combine_tables (), remove_tables (), mark_tables_done ();
+  int n, nrunning, nfailed, status;
+  pid_t pid;
+
+  sprintf (windsavefile, "%s.wind_save", roots[0]);
+  if (wind_read_select (windsavefile, WIND_READ_KEEP_ATOMIC) < 0)
+  {
+    Error ("batch_tables: Could not open %s\n", windsavefile);
+    exit (0);
+  }
+
+  printf ("batch_tables: Making tables for %d models, %d at a time\n", nroots, njobs);
+
+  remove_tables (nroots, roots);
+
+  nrunning = nfailed = 0;
+  for (n = 0; n < nroots; n++)
+  {
+    if (nrunning == njobs)
+    {                           //Wait for one of the models to finish
+      wait (&status);
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        nfailed++;
+      nrunning--;
+    }
+
+    fflush (stdout);            //So that output which is already buffered is not repeated by the child
+    pid = fork ();
+    if (pid == 0)
+    {
+      status = windsave2table_model (roots[n], WIND_READ_DENSITY | WIND_READ_KEEP_ATOMIC);
+      if (status == 0)
+        mark_tables_done (roots[n]);
+      fflush (stdout);
+      _exit (status < 0 ? 1 : 0);
+    }
+    else if (pid < 0)
+    {                           //If we cannot fork, just process the model here
+      Error ("batch_tables: Could not fork for %s, processing it directly\n", roots[n]);
+      if (windsave2table_model (roots[n], WIND_READ_DENSITY) < 0)
+        nfailed++;
+      else
+        mark_tables_done (roots[n]);
+    }
+    else
+    {
+      nrunning++;
+    }
+  }
+
+  while (wait (&status) > 0)
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+      nfailed++;
+
+  if (nfailed > 0)
+  {
+    Error ("batch_tables: %d of the %d models could not be processed, so the tables have not been combined\n", nfailed, nroots);
+    return (0);
+  }
+
+  combine_tables (nroots, roots, outroot);
+
+  return (0);
+}
+
+
+
+/* table_names lists the names of the tables, as they appear in the filenames, and returns how many there are */
+
+int
+table_names (tables)
+     char tables[][20];
+{
+  int i, n, ntables;
+
+  strcpy (tables[0], "master");
+  ntables = 1;
+  for (i = 0; i < NTABLE_ELEMENTS; i++)
+    for (n = 0; n < nelements; n++)
+      if (ele[n].z == table_elements[i])
+        strcpy (tables[ntables++], ele[n].name);
+
+  return (ntables);
+}
+
+
+
+/* mark_tables_done writes an empty file, root.tables_done, to show that all of the tables of a model were made */
+
+int
+mark_tables_done (root)
+     char root[];
+{
+  FILE *fptr;
+  char filename[LINELENGTH];
+
+  sprintf (filename, "%s.tables_done", root);
+  if ((fptr = fopen (filename, "w")) == NULL)
+  {
+    Error ("mark_tables_done: Could not open %s\n", filename);
+    return (-1);
   }
+  fclose (fptr);
+
   return (0);
 }
 
 
 
+/* remove_tables removes the binary tables of the models, for all of the domains they might have, and their marks */
+
+int
+remove_tables (nroots, roots)
+     int nroots;
+     char *roots[];
+{
+  char filename[LINELENGTH], tables[NTABLE_ELEMENTS + 1][20];
+  int n, ndom, t, ntables;
+
+  ntables = table_names (tables);
+  for (n = 0; n < nroots; n++)
+    for (ndom = 0; ndom < MaxDom; ndom++)
+      for (t = 0; t < ntables; t++)
+      {
+        sprintf (filename, "%s.%d.%s.bin", roots[n], ndom, tables[t]);
+        remove (filename);
+      }
+  for (n = 0; n < nroots; n++)
+  {
+    sprintf (filename, "%s.tables_done", roots[n]);
+    remove (filename);
+  }
+
+  return (0);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+ Synopsis:
+	combine_tables joins the tables of a number of models into one table
+
+Arguments:		
+
+	nroots		the number of models
+	roots		their roots
+	outroot		the root name for the combined tables
+
+Returns:
+
+	The number of combined tables written
+ 
+Description:	
+
+	For each domain, and each of the tables (master and the ion tables), 
+	the binary tables of the models are read, and the rows of all of them 
+	written to outroot.<domain>.<table>.txt and outroot.<domain>.<table>.bin.
+	The first column of the combined tables, model, is the index of the
+	model in roots.
+
+	Every model must have the file root.tables_done, which batch_tables
+	writes once all of the tables of a model have been made.  If one does
+	not, the model could not be processed, even if the process which made
+	its tables finished normally, e.g. because it stopped with exit (0) 
+	after an error.  In that case nothing is combined, since the combined
+	tables would silently be missing that model.
+
+	Otherwise models which do not have a table, because they have fewer 
+	domains, are skipped, as are models whose table has different columns
+	to the first model, which can happen if the domains have different
+	coordinate systems.
+
+Notes:
+
+**************************************************************/
+
+int
+combine_tables (nroots, roots, outroot)
+     int nroots;
+     char *roots[];
+     char outroot[];
+{
+  FILE *fptr;
+  char filename[LINELENGTH], tables[NTABLE_ELEMENTS + 1][20];
+  char names[71][20], first_names[71][20];
+  double *data, *cols[71];
+  int write_table_binary (), table_names ();
+  double *read_table_binary ();
+  int ndom, ntables, t, i, n, k, found, nwritten, nmissing;
+  int ncols, nrows, ncols_first, nrows_total, nalloc;
+
+  nmissing = 0;
+  for (n = 0; n < nroots; n++)
+  {
+    sprintf (filename, "%s.tables_done", roots[n]);
+    if (access (filename, F_OK) != 0)
+    {
+      Error ("combine_tables: %s is missing, so the tables of %s were not all made\n", filename, roots[n]);
+      nmissing++;
+    }
+  }
+  if (nmissing > 0)
+  {
+    Error ("combine_tables: %d of the %d models were not processed completely, so the tables have not been combined\n", nmissing, nroots);
+    return (0);
+  }
+
+  ntables = table_names (tables);
+
+  nwritten = 0;
+  found = 1;
+  for (ndom = 0; found; ndom++)
+  {
+    found = 0;
+    for (t = 0; t < ntables; t++)
+    {
+      fptr = NULL;
+      ncols_first = 0;
+      nrows_total = nalloc = 0;
+      for (n = 0; n < nroots; n++)
+      {
+        sprintf (filename, "%s.%d.%s.bin", roots[n], ndom, tables[t]);
+        if ((data = read_table_binary (filename, &ncols, names, &nrows)) == NULL)
+          continue;
+
+        if (fptr == NULL)
+        {                       //This is the first model with this table, so set up the combined table
+          found = 1;
+          ncols_first = ncols;
+          strcpy (first_names[0], "model");
+          for (i = 0; i < ncols; i++)
+            strcpy (first_names[i + 1], names[i]);
+
+          sprintf (filename, "%s.%d.%s.txt", outroot, ndom, tables[t]);
+          if ((fptr = fopen (filename, "w")) == NULL)
+          {
+            Error ("combine_tables: Could not open %s\n", filename);
+            exit (0);
+          }
+          fprintf (fptr, "%5s ", "model");
+          for (i = 0; i < ncols; i++)
+            fprintf (fptr, "%9s ", names[i]);
+          fprintf (fptr, "\n");
+          for (i = 0; i <= ncols; i++)
+            cols[i] = NULL;
+        }
+        else
+        {                       //Check that this model has the same columns
+          for (i = 0; i < ncols && ncols == ncols_first; i++)
+            if (strcmp (names[i], first_names[i + 1]) != 0)
+              break;
+          if (ncols != ncols_first || i < ncols)
+          {
+            Error ("combine_tables: %s has different columns to the first model, skipping it\n", roots[n]);
+            free (data);
+            continue;
+          }
+        }
+
+        /* Add the rows of this model to the combined table */
+        if (nrows_total + nrows > nalloc)
+        {
+          nalloc = 2 * (nrows_total + nrows);
+          for (i = 0; i <= ncols; i++)
+            cols[i] = (double *) realloc (cols[i], nalloc * sizeof (double));
+        }
+        for (k = 0; k < nrows; k++)
+        {
+          cols[0][nrows_total + k] = n;
+          fprintf (fptr, "%5d ", n);
+          for (i = 0; i < ncols; i++)
+          {
+            cols[i + 1][nrows_total + k] = data[i * nrows + k];
+            fprintf (fptr, "%9.2e ", data[i * nrows + k]);
+          }
+          fprintf (fptr, "\n");
+        }
+        nrows_total += nrows;
+        free (data);
+      }
+
+      if (fptr != NULL)
+      {
+        fclose (fptr);
+        sprintf (filename, "%s.%d.%s.bin", outroot, ndom, tables[t]);
+        write_table_binary (filename, ncols_first + 1, first_names, cols, nrows_total);
+        for (i = 0; i <= ncols_first; i++)
+          free (cols[i]);
+        nwritten++;
+      }
+    }
+  }
+
+  for (n = 0; n < nroots; n++)
+  {
+    sprintf (filename, "%s.tables_done", roots[n]);
+    remove (filename);
+  }
+
+  printf ("combine_tables: Wrote %d combined tables to %s.*\n", nwritten, outroot);
+  return (nwritten);
+}
+
+
 
 /***********************************************************
                                        Space Telescope Science Institute
@@ -177,14 +741,17 @@ create_master_table (ndom, rootname)
   char filename[132];
   double *get_one ();
   double *get_ion ();
+  int table_cell_columns (), write_table_binary ();
   double *c[50], *converge;
   char column_name[50][20];
   char one_line[1024], start[132], one_value[20];
+  double *bcol[70];
+  char bname[70][20];
 
 
   int i, ii, jj;
   int nstart, nstop, ndim2;
-  int n, ncols;
+  int n, ncols, nb;
   FILE *fopen (), *fptr;
 
   strcpy (filename, rootname);
@@ -333,6 +900,26 @@ create_master_table (ndom, rootname)
       fprintf (fptr, "%s\n", one_line);
     }
   }
+  fclose (fptr);
+
+  /* Now write the same table in binary form */
+
+  strcpy (filename, rootname);
+  strcat (filename, ".master.bin");
+
+  nb = table_cell_columns (ndom, 1, bname, bcol);
+  strcpy (bname[nb], "converge");
+  bcol[nb++] = converge;
+  for (n = 0; n < ncols; n++)
+  {
+    strcpy (bname[nb], column_name[n]);
+    bcol[nb++] = c[n];
+  }
+  write_table_binary (filename, nb, bname, bcol, ndim2);
+
+  /* All of the columns, including those from get_one, were allocated for this table */
+  for (n = 0; n < nb; n++)
+    free (bcol[n]);
 
   return (0);
 }
@@ -380,15 +967,18 @@ create_ion_table (ndom, rootname, iz)
   char filename[132];
   double *get_one ();
   double *get_ion ();
+  int table_cell_columns (), write_table_binary ();
   double *c[50];
   int first_ion, number_ions;
   char element_name[20];
   int istate[50];
   char one_line[1024], start[132], one_value[20];
   int nstart, nstop, ndim2;
+  double *bcol[60];
+  char bname[60][20];
 
 
-  int i, ii, jj, n;
+  int i, ii, jj, n, nb;
   FILE *fopen (), *fptr;
 
 /* First we actually need to determine what ions exits, but we will ignore this for now */
@@ -505,6 +1095,23 @@ create_ion_table (ndom, rootname, iz)
       fprintf (fptr, "%s\n", one_line);
     }
   }
+  fclose (fptr);
+
+  /* Now write the same table in binary form */
+
+  sprintf (filename, "%s.%s.bin", rootname, element_name);
+
+  nb = table_cell_columns (ndom, 0, bname, bcol);
+  for (n = 0; n < number_ions; n++)
+  {
+    sprintf (bname[nb], "i%02d", istate[n]);
+    bcol[nb++] = c[n];
+  }
+  write_table_binary (filename, nb, bname, bcol, ndim2);
+
+  /* All of the columns, including those from get_ion, were allocated for this table */
+  for (n = 0; n < nb; n++)
+    free (bcol[n]);
 
   return (0);
 
@@ -512,6 +1119,188 @@ create_ion_table (ndom, rootname, iz)
 
 
 
+/***********************************************************
+                                       Space Telescope Science Institute
+
+Synopsis:
+
+	table_cell_columns makes the columns which describe the position of
+	each cell in the tables
+
+Arguments:		
+
+	ndom	the domain number
+	with_v	if set, also make columns for the velocity
+	names	the column names, which are returned
+	cols	the columns, which are returned
+
+Returns:
+
+	The number of columns
+ 
+Description:	
+
+	These are the columns which are written at the start of each line of
+	the ascii tables: r, i and inwind for spherical grids, otherwise x, z, 
+	i, j and inwind.  The velocity columns are v_x, v_y and v_z.
+
+Notes:
+
+	Each column is allocated here, and has to be freed by the caller
+	once the table has been written.
+
+**************************************************************/
+
+int
+table_cell_columns (ndom, with_v, names, cols)
+     int ndom, with_v;
+     char names[][20];
+     double *cols[];
+{
+  int i, ii, jj, n, nc;
+  int nstart, ndim2;
+
+  nstart = zdom[ndom].nstart;
+  ndim2 = zdom[ndom].ndim2;
+
+  nc = (zdom[ndom].coord_type == SPHERICAL ? 3 : 5) + (with_v ? 3 : 0);
+  for (n = 0; n < nc; n++)
+    cols[n] = (double *) calloc (sizeof (double), ndim2);
+
+  if (zdom[ndom].coord_type == SPHERICAL)
+  {
+    strcpy (names[0], "r");
+    strcpy (names[1], "i");
+    strcpy (names[2], "inwind");
+    for (i = 0; i < ndim2; i++)
+    {
+      cols[0][i] = wmain[nstart + i].r;
+      cols[1][i] = i;
+      cols[2][i] = wmain[nstart + i].inwind;
+    }
+    n = 3;
+  }
+  else
+  {
+    strcpy (names[0], "x");
+    strcpy (names[1], "z");
+    strcpy (names[2], "i");
+    strcpy (names[3], "j");
+    strcpy (names[4], "inwind");
+    for (i = 0; i < ndim2; i++)
+    {
+      wind_n_to_ij (ndom, nstart + i, &ii, &jj);
+      cols[0][i] = wmain[nstart + i].xcen[0];
+      cols[1][i] = wmain[nstart + i].xcen[2];
+      cols[2][i] = ii;
+      cols[3][i] = jj;
+      cols[4][i] = wmain[nstart + i].inwind;
+    }
+    n = 5;
+  }
+
+  if (with_v)
+  {
+    strcpy (names[n], "v_x");
+    strcpy (names[n + 1], "v_y");
+    strcpy (names[n + 2], "v_z");
+    for (i = 0; i < ndim2; i++)
+    {
+      cols[n][i] = wmain[nstart + i].v[0];
+      cols[n + 1][i] = wmain[nstart + i].v[1];
+      cols[n + 2][i] = wmain[nstart + i].v[2];
+    }
+  }
+
+  return (nc);
+}
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+Synopsis:
+
+	write_table_binary writes a table in a simple binary columnar format
+
+Arguments:		
+
+	filename	the name of the file to write
+	ncols		the number of columns
+	names		the names of the columns
+	cols		the columns
+	nrows		the length of each column
+
+Returns:
+
+	0 on success, -1 if the file could not be written
+ 
+Description:	
+
+	The file starts with the 8 character string PYTABLE, followed by
+	2 ints, the number of columns and the number of rows.  Then come
+	the column names, each in 20 characters padded with nulls, and 
+	then the columns one after the other as doubles.  All the numbers
+	are in the byte order of the machine the file was written on.
+
+Notes:
+
+	Since each column is contiguous, a single column can be read
+	from a large number of files without reading the whole table.
+	py_progs/py_read_output.py has a routine, read_table_binary, which
+	reads these files.
+
+**************************************************************/
+
+int
+write_table_binary (filename, ncols, names, cols, nrows)
+     char filename[];
+     int ncols;
+     char names[][20];
+     double *cols[];
+     int nrows;
+{
+  FILE *fptr;
+  char magic[8], name[20];
+  int n, head[2];
+
+  if ((fptr = fopen (filename, "wb")) == NULL)
+  {
+    Error ("write_table_binary: Unable to open %s\n", filename);
+    return (-1);
+  }
+
+  memset (magic, 0, sizeof (magic));
+  strcpy (magic, "PYTABLE");
+  head[0] = ncols;
+  head[1] = nrows;
+  fwrite (magic, sizeof (magic), 1, fptr);
+  fwrite (head, sizeof (int), 2, fptr);
+
+  for (n = 0; n < ncols; n++)
+  {
+    memset (name, 0, sizeof (name));
+    strncpy (name, names[n], sizeof (name) - 1);
+    fwrite (name, sizeof (name), 1, fptr);
+  }
+
+  for (n = 0; n < ncols; n++)
+  {
+    if (fwrite (cols[n], sizeof (double), nrows, fptr) != (size_t) nrows)
+    {
+      Error ("write_table_binary: Problem writing %s\n", filename);
+      fclose (fptr);
+      return (-1);
+    }
+  }
+
+  fclose (fptr);
+  return (0);
+}
+
+
+
 /***********************************************************
                                        Space Telescope Science Institute
 
@@ -727,3 +1516,70 @@ get_one (ndom, variable_name)
   return (x);
 
 }
+
+
+
+/***********************************************************
+                                       Space Telescope Science Institute
+
+Synopsis:
+
+	read_table_binary reads a table written by write_table_binary
+
+Arguments:		
+
+	filename	the name of the file to read
+	ncols		the number of columns, which is returned
+	names		the names of the columns, which are returned; there must
+			be space for 70 of them
+	nrows		the length of each column, which is returned
+
+Returns:
+
+	The columns, one after the other in a single array which the caller
+	should free, or NULL if the file could not be read
+ 
+Notes:
+
+**************************************************************/
+
+double *
+read_table_binary (filename, ncols, names, nrows)
+     char filename[];
+     int *ncols;
+     char names[][20];
+     int *nrows;
+{
+  FILE *fptr;
+  char magic[8];
+  double *data;
+  int n, head[2];
+
+  if ((fptr = fopen (filename, "rb")) == NULL)
+    return (NULL);
+
+  if (fread (magic, sizeof (magic), 1, fptr) != 1 || strncmp (magic, "PYTABLE", 8) != 0
+      || fread (head, sizeof (int), 2, fptr) != 2 || head[0] < 1 || head[0] > 70 || head[1] < 0)
+  {
+    Error ("read_table_binary: %s is not a binary table\n", filename);
+    fclose (fptr);
+    return (NULL);
+  }
+
+  *ncols = head[0];
+  *nrows = head[1];
+  for (n = 0; n < *ncols; n++)
+    if (fread (names[n], 20, 1, fptr) != 1)
+      break;
+
+  data = (double *) calloc (sizeof (double), (size_t) * ncols * *nrows + 1);
+  if (n < *ncols || fread (data, sizeof (double), (size_t) * ncols * *nrows, fptr) != (size_t) * ncols * *nrows)
+  {
+    Error ("read_table_binary: %s is incomplete\n", filename);
+    free (data);
+    data = NULL;
+  }
+
+  fclose (fptr);
+  return (data);
+}